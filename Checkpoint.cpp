@@ -0,0 +1,30 @@
+#include "Checkpoint.hpp"
+
+static constexpr char checkpointMagic[8] = { 'B', 'U', 'S', 'C', 'K', 'P', 'T', '6' }; // 檔頭 (含格式版本)
+
+CheckpointWriter::CheckpointWriter(const string& path) {
+    writer.open(path);
+    writer.write(checkpointMagic, sizeof(checkpointMagic));
+}
+
+CheckpointReader::CheckpointReader(const string& path) {
+/**
+ * @brief 讀入整個檢查點檔案並檢查檔頭
+ *
+ * @param path 檢查點檔案路徑
+ * @throws runtime_error 若無法開啟檔案或檔頭不符
+ */
+    ifstream file(path, ios::binary);
+    if (!file) throw runtime_error("無法開啟檢查點檔案 " + path);
+    data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+
+    char magic[sizeof(checkpointMagic)];
+    read(magic, sizeof(magic));
+    if (memcmp(magic, checkpointMagic, sizeof(magic)) != 0) throw runtime_error(path + " 不是檢查點檔案或版本不符");
+}
+
+void CheckpointReader::read(void* out, size_t size) {
+    if (size > data.size() - pos) throw runtime_error("檢查點檔案損毀 (資料不足)");
+    memcpy(out, data.data() + pos, size);
+    pos += size;
+}
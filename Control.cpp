@@ -0,0 +1,38 @@
+#include "Control.hpp"
+
+Advice SpeedAdvisor::advise(double Vavg, int headway, int dwell, optional<double> distance) const {
+/**
+ * @brief 計算駛離站點時的建議速度與下一站置站時間
+ *
+ * @param Vavg 本次行駛的平均速度 (m/s)
+ * @param headway 發車間距 (秒)
+ * @param dwell 下一站的預估置站時間 (秒)
+ * @param distance 與前車的距離 (公尺，第一班車為空)
+ * @return Advice 建議速度、置站時間及前車的等候時間
+ */
+    Advice advice{ Vavg, dwell };
+    if (!distance) return advice;  // 第一班車不跟隨其他車輛的速度
+
+    double d = *distance;
+    double newVol = d / (headway + dwell);  // 計算新速度
+
+    // 如果與前車的距離足夠，則以平均速度行駛
+    if ((d / Vavg) < headway * this->threshold) {
+        newVol = Vavg;
+    } else {
+        advice.bunching = true;  // 可能發生連班，使用控制策略
+    }
+
+    // 如果速度太低，以平均速度行駛並於下一站持車；如果速度過快，則限制速度並由前車等候
+    if (newVol < this->Vlow) {
+        advice.adjust = Advice::TooClose;
+        advice.dwell += (d / newVol) - (d / Vavg);
+        newVol = Vavg;
+    } else if (newVol > this->Vlimit) {
+        advice.adjust = Advice::TooFar;
+        advice.leaderHold = (d / this->Vlimit) - (d / newVol);
+        newVol = this->Vlimit;
+    }
+    advice.vol = newVol;
+    return advice;
+}
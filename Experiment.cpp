@@ -0,0 +1,211 @@
+#include "Experiment.hpp"
+
+Outcome Outcome::of(const System& system) {
+    const Metrics& metrics = system.getMetrics();
+    return { { system.getHeadwayDeviation(), metrics.headway().cv(), metrics.excessWaitTime(), static_cast<double>(metrics.bunchingEpisodes()) } };
+}
+
+double Experiment::tQuantile(long long df) {
+/**
+ * @brief 學生 t 分佈的 97.5% 分位數 (df <= 30 查表；之後以 Cornish-Fisher 展開，誤差小於 0.01%)
+ *
+ * 展開式在自由度很小時誤差很大 (df = 2 時低估約 10%)，配對比較最少只有 2 次重複，因此小自由度改為查表。
+ *
+ * @param df 自由度
+ */
+    static constexpr array<double, 30> table = {
+        12.706205, 4.302653, 3.182446, 2.776445, 2.570582, 2.446912, 2.364624, 2.306004, 2.262157, 2.228139,
+        2.200985, 2.178813, 2.160369, 2.144787, 2.131450, 2.119905, 2.109816, 2.100922, 2.093024, 2.085963,
+        2.079614, 2.073873, 2.068658, 2.063899, 2.059539, 2.055529, 2.051831, 2.048407, 2.045230, 2.042272
+    };
+    if (df <= static_cast<long long>(table.size())) return table[max(1LL, df) - 1];
+    const double z = 1.959963985;
+    double n = df;
+    return z + (z * z * z + z) / (4 * n) + (5 * pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * n * n);
+}
+
+void Experiment::parallelFor(int threads, long long tasks, const function<bool(long long, int)>& task) {
+/**
+ * @brief 以 threads 個執行緒依序領取工作 0 .. tasks - 1 並執行 task；task 回傳 false 或拋出例外後不再分配新工作
+ *
+ * 例外不可離開執行緒函式 (否則以 std::terminate 結束程式)，因此各執行緒捕捉例外並保留第一個，
+ * 所有執行緒結束後再於呼叫端的執行緒重新拋出。
+ *
+ * @param threads 執行緒數
+ * @param tasks 工作數
+ * @param task 以第 t 個執行緒執行第 k 個工作 (k, t)，回傳是否繼續分配新工作；t 可用於索引各執行緒的暫存資料
+ * @throws 工作中拋出的第一個例外
+ */
+    atomic<long long> next = 0;
+    atomic<bool> stop = false;
+    exception_ptr error;
+    mutex lock;
+    vector<thread> workers;
+    for (int t = 0; t < min<long long>(max(1, threads), tasks); t++) {
+        workers.emplace_back([&, t]() {
+            try {
+                for (long long k; !stop && (k = next++) < tasks;) {
+                    if (!task(k, t)) stop = true;
+                }
+            } catch (...) {
+                lock_guard<mutex> guard(lock);
+                if (!error) error = current_exception();
+                stop = true;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    if (error) rethrow_exception(error);
+}
+
+Experiment::Experiment(const string& configPath) {
+/**
+ * @brief 讀取設定檔中的比較設定
+ *
+ * [compare] 區段: runs (重複次數)、threads、at (分支時刻 HHMM，可省略)、day (分支日，預設 1)、output (逐次結果 CSV)，
+ * 以及兩個以上的 [[compare.variant]]，各含 name 與要覆寫的控制參數，例如 time = { schemeThreshold = 0.5 }。
+ *
+ * @param configPath 設定檔路徑
+ * @throws runtime_error 若策略少於兩個或含有無法覆寫的參數
+ */
+    this->config = toml::parse_file(configPath);
+    this->runs = max(2, this->config["compare"]["runs"].value_or(30));
+    this->threads = clamp(this->config["compare"]["threads"].value_or(1), 1, this->runs);
+    this->outputPath = this->config["compare"]["output"].value_or("");
+    if (auto at = this->config["compare"]["at"].value<string>()) {
+        this->forkAt = System::time2Seconds(*at) + (this->config["compare"]["day"].value_or(1) - 1) * 86400;
+    }
+    auto seed = this->config["general"]["seed"].value<int64_t>();
+    this->baseSeed = seed ? static_cast<uint64_t>(*seed) : random_device{}();
+
+    if (auto list = this->config["compare"]["variant"].as_array()) {
+        for (auto& node : *list) {
+            auto* table = node.as_table();
+            if (!table) throw runtime_error("錯誤: 'compare.variant' 必須為表格陣列 ([[compare.variant]])");
+            Variant variant;
+            variant.name = (*table)["name"].value_or("variant" + to_string(this->variants.size()));
+            for (auto& [section, values] : *table) {
+                if (!values.is_table()) continue;
+                for (auto& [key, value] : *values.as_table()) {
+                    auto number = value.value<double>();
+                    if (!number) throw runtime_error("錯誤: 策略 " + variant.name + " 的 '" + string(section.str()) + "." + string(key.str()) + "' 必須為數值");
+                    variant.controls.emplace_back(string(section.str()) + "." + string(key.str()), *number);
+                }
+            }
+            this->variants.push_back(move(variant));
+        }
+    }
+    if (this->variants.size() < 2) throw runtime_error("錯誤: 配對比較至少需要兩個 [[compare.variant]]");
+}
+
+toml::table Experiment::batch(const toml::table& config) {
+/**
+ * @brief 複製設定並關閉事件記錄、所有輸出與檢查點，供大量重複模擬使用
+ *
+ * 回傳的設定一定含有 general 區段，呼叫端可直接以 insert_or_assign 修改種子等欄位後重複使用。
+ *
+ * @param config 設定
+ * @return toml::table 批次模擬用的設定
+ */
+    toml::table table = config;
+    auto set = [&](const char* section, const char* key, auto value) {
+        if (!table.contains(section)) table.insert(section, toml::table{});
+        table[section].as_table()->insert_or_assign(key, value);
+    };
+    if (!table.contains("general")) table.insert("general", toml::table{});
+    set("output", "verbose", false);
+    set("output", "trajectory", "");
+    set("output", "trace", "");
+    set("output", "queues", "");
+    set("checkpoint", "save", "");
+    set("checkpoint", "restore", "");
+    return table;
+}
+
+unique_ptr<System> Experiment::prepare(const toml::table& config, uint64_t seed, int forkAt) {
+/**
+ * @brief 以指定種子初始化系統 (關閉事件記錄與所有輸出)，並模擬至分支時刻
+ *
+ * @param config 設定
+ * @param seed 亂數種子
+ * @param forkAt 分支時刻 (秒，-1 表示初始化後立即返回)
+ * @return unique_ptr<System> 待分支的系統
+ */
+    toml::table table = Experiment::batch(config);
+    table["general"].as_table()->insert_or_assign("seed", static_cast<int64_t>(seed));
+
+    auto system = make_unique<System>();
+    system->init(table);
+    if (forkAt >= 0) {
+        system->setPause(forkAt);
+        system->simulation();
+    }
+    return system;
+}
+
+void Experiment::compare() {
+/**
+ * @brief 配對比較: 每次重複實驗自同一狀態 fork 出各策略，輸出各策略與基準 (第一個策略) 的差異
+ *
+ * 同一次重複實驗的各策略共用路線、班表及需求與速度抽樣，配對差值的變異數遠小於兩組獨立重複實驗，
+ * 「變異數比」為 (Var(A) + Var(B)) / Var(A - B)，即獨立重複實驗達到相同信賴區間所需的次數倍數。
+ * 不同重複實驗之間平行執行 (`parallelFor`)，結果依重複實驗編號存放，輸出與執行緒數無關。
+ */
+    int count = this->variants.size();
+    vector<vector<Outcome>> results(this->runs, vector<Outcome>(count));
+
+    Experiment::parallelFor(this->threads, this->runs, [&](long long r, int) {
+        auto base = Experiment::prepare(this->config, this->baseSeed + r, this->forkAt);
+        for (int v = 0; v < count; v++) {
+            auto system = base->fork();
+            for (auto& [key, value] : this->variants[v].controls) system->setControl(key, value);
+            system->simulation();
+            results[r][v] = Outcome::of(*system);
+        }
+        return true;
+    });
+
+    if (!this->outputPath.empty()) {
+        BufferedWriter file;
+        file.open(this->outputPath);
+        file << "run,variant";
+        for (auto* name : Outcome::names) file << "," << name;
+        file << "\n";
+        for (int r = 0; r < this->runs; r++) {
+            for (int v = 0; v < count; v++) {
+                file << r << "," << this->variants[v].name;
+                for (double value : results[r][v].values) file << "," << value;
+                file << "\n";
+            }
+        }
+        file.close();
+    }
+
+    /* 配對差值統計 */
+    double t = tQuantile(this->runs - 1);
+    cout << ">>> Paired comparison <<<\n";
+    cout << "Runs: " << this->runs << " (seeds " << this->baseSeed << " .. " << this->baseSeed + this->runs - 1 << ")";
+    if (this->forkAt >= 0) cout << ", forked at " << this->forkAt << " s";
+    cout << "\nBaseline: " << this->variants[0].name << "\n";
+    cout << fixed << setprecision(4);
+    for (int v = 1; v < count; v++) {
+        cout << "\n" << this->variants[v].name << " - " << this->variants[0].name << "\n";
+        for (int m = 0; m < Outcome::count; m++) {
+            Welford base, other, diff;
+            for (int r = 0; r < this->runs; r++) {
+                base.add(results[r][0].values[m]);
+                other.add(results[r][v].values[m]);
+                diff.add(results[r][v].values[m] - results[r][0].values[m]);
+            }
+            double paired = t * diff.sd() / sqrt(this->runs);
+            double independent = t * sqrt((base.variance() + other.variance()) / this->runs);
+            cout << "  " << left << setw(18) << Outcome::names[m] << right
+                 << " " << setw(12) << base.mean << " -> " << setw(12) << other.mean
+                 << "  diff " << setw(11) << diff.mean << " +/- " << setw(10) << paired
+                 << "  (independent +/- " << independent << ", variance ratio ";
+            if (diff.variance() > 0) cout << (base.variance() + other.variance()) / diff.variance() << ")\n";
+            else cout << "inf)\n";
+        }
+    }
+    cout << defaultfloat;
+}
@@ -0,0 +1,214 @@
+#include "FleetState.hpp"
+#include "Checkpoint.hpp"
+
+int FleetState::add(int hdwy) {
+/**
+ * @brief 新增一個尚未發車的班次 (車位於發車時才配置)
+ *
+ * @param hdwy 與上一班車的發車間距 (秒)
+ * @return int 新班次的公車編號
+ */
+    int id = state.size();
+    schedHeadway.push_back(hdwy);
+    state.push_back(TripState::Pending);
+    slotOf.push_back(-1);
+    return id;
+}
+
+int FleetState::activate(int id) {
+/**
+ * @brief 班次發車: 取得車位並以初始值重設各欄位，加入營運中車輛
+ *
+ * 優先重複使用已退出營運的車位；沒有可用車位時才擴充陣列。
+ *
+ * @param id 公車編號
+ * @return int 車位編號
+ */
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = location.size();
+        trip.push_back(0);
+        location.push_back(0);
+        vol.push_back(0);
+        nextVol.push_back(0);
+        cruise.push_back(0);
+        pax.push_back(0);
+        dwell.push_back(0);
+        stopDwell.push_back(0);
+        lastGo.push_back(0);
+        headway.push_back(0);
+        dropRate.push_back(0);
+        bunching.push_back({0, 0});
+        target.push_back(-1);
+        eta.push_back(0);
+        ahead.push_back(-1);
+        behind.push_back(-1);
+        activeIndex.push_back(-1);
+    }
+
+    trip[slot] = id;
+    location[slot] = 0;
+    vol[slot] = 0;
+    nextVol[slot] = 0;
+    cruise[slot] = 0;
+    pax[slot] = 0;
+    dwell[slot] = 0;
+    stopDwell[slot] = 0;
+    lastGo[slot] = 0;
+    headway[slot] = schedHeadway[id];
+    dropRate[slot] = 0;
+    bunching[slot] = {0, 0};
+    target[slot] = -1;
+    eta[slot] = 0;
+
+    /* 新發車的車輛位於起點站，排在所有營運中車輛之後 */
+    ahead[slot] = tail;
+    behind[slot] = -1;
+    if (tail >= 0) behind[tail] = slot;
+    tail = slot;
+
+    activeIndex[slot] = active.size();
+    active.push_back(slot);
+    state[id] = TripState::Active;
+    slotOf[id] = slot;
+    return slot;
+}
+
+void FleetState::retire(int id) {
+/**
+ * @brief 班次抵達終點站: 自營運中車輛移除 (與末端交換後刪除) 並歸還車位
+ *
+ * 車位欄位保留至下次重複使用為止，因此同一事件中仍可讀取該車的最終狀態。
+ *
+ * @param id 公車編號
+ */
+    int slot = slotOf[id];
+    int index = activeIndex[slot], last = active.back();
+    active[index] = last;
+    activeIndex[last] = index;
+    active.pop_back();
+    activeIndex[slot] = -1;
+    freeSlots.push_back(slot);
+
+    if (ahead[slot] >= 0) behind[ahead[slot]] = behind[slot];
+    if (behind[slot] >= 0) ahead[behind[slot]] = ahead[slot];
+    else tail = ahead[slot];
+    state[id] = TripState::Finished;
+}
+
+void FleetState::reserve(size_t trips) {
+    schedHeadway.reserve(trips);
+    state.reserve(trips);
+    slotOf.reserve(trips);
+}
+
+int FleetState::leader(int slot) const {
+/**
+ * @brief 取得前車: 營運中且位置大於目標車輛的車輛中位置最小者
+ *
+ * 只掃描營運中的車位，成本與同時在路上的車輛數成正比；
+ * 尚未發車與已抵達終點站的班次不會作為前車。
+ *
+ * @param slot 目標車位編號
+ * @return int 前車車位編號；若目標車輛已在最前方則回傳 -1
+ */
+    int target = location[slot], best = -1, bestLocation = INT_MAX;
+    for (int i : active) {
+        if (location[i] > target && location[i] < bestLocation) {
+            bestLocation = location[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+int FleetState::orderedLeader(int slot) const {
+/**
+ * @brief 沿車輛先後順序取得前車: 位置大於目標車輛的第一輛車
+ *
+ * 禁止超車時先後順序即為沿路線的順序，前車通常就是 ahead[slot]；
+ * 只有同一位置 (同時停靠或同時駛離同一元素) 的車輛需要略過，成本為 O(1)。
+ *
+ * @param slot 目標車位編號
+ * @return int 前車車位編號；若目標車輛已在最前方則回傳 -1
+ */
+    int i = ahead[slot];
+    while (i >= 0 && location[i] <= location[slot]) i = ahead[i];
+    return i;
+}
+
+void FleetState::overtake(int slot) {
+/**
+ * @brief 駛離站點時，超越仍停靠於同一站 (尚未駛離) 的前車
+ *
+ * 只調整鏈結串列中的先後順序；站點允許後車越過停靠中的前車，路段上則不允許超車。
+ *
+ * @param slot 駛離站點的車位編號
+ */
+    int front;
+    while ((front = ahead[slot]) >= 0 && target[front] < 0 && location[front] == location[slot]) {
+        int before = ahead[front], after = behind[slot];
+        if (before >= 0) behind[before] = slot;
+        ahead[slot] = before;
+        behind[slot] = front;
+        ahead[front] = slot;
+        behind[front] = after;
+        if (after >= 0) ahead[after] = front;
+        else tail = front;
+    }
+}
+
+void FleetState::save(CheckpointWriter& out) const {
+    out.put(schedHeadway);
+    out.put(state);
+    out.put(slotOf);
+    out.put(trip);
+    out.put(location);
+    out.put(vol);
+    out.put(nextVol);
+    out.put(cruise);
+    out.put(pax);
+    out.put(dwell);
+    out.put(stopDwell);
+    out.put(lastGo);
+    out.put(headway);
+    out.put(dropRate);
+    out.put(bunching);
+    out.put(target);
+    out.put(eta);
+    out.put(ahead);
+    out.put(behind);
+    out.put(tail);
+    out.put(active);
+    out.put(activeIndex);
+    out.put(freeSlots);
+}
+
+void FleetState::load(CheckpointReader& in) {
+    in.get(schedHeadway);
+    in.get(state);
+    in.get(slotOf);
+    in.get(trip);
+    in.get(location);
+    in.get(vol);
+    in.get(nextVol);
+    in.get(cruise);
+    in.get(pax);
+    in.get(dwell);
+    in.get(stopDwell);
+    in.get(lastGo);
+    in.get(headway);
+    in.get(dropRate);
+    in.get(bunching);
+    in.get(target);
+    in.get(eta);
+    in.get(ahead);
+    in.get(behind);
+    in.get(tail);
+    in.get(active);
+    in.get(activeIndex);
+    in.get(freeSlots);
+}
@@ -0,0 +1,261 @@
+#include "Generator.hpp"
+
+Generator::Generator(const GeneratorConfig& config) : config(config), gen(config.seed) {}
+
+void Generator::writeAll(const string& dir) {
+/**
+ * @brief 輸出完整情境: dir/config.toml 及 dir/data 下的 stops.csv、signals.csv、schedule.csv
+ *
+ * `gtfsRoutes` 大於 0 時以 dir/data/gtfs 下的 GTFS feed 取代 schedule.csv；`congestion` 大於 0 時另輸出 link_speeds.csv。
+ *
+ * @param dir 輸出目錄 (不存在時自動建立)
+ */
+    filesystem::create_directories(dir + "/data");
+    this->writeStops(dir + "/data/stops.csv");
+    this->writeSignals(dir + "/data/signals.csv");
+    if (config.gtfsRoutes > 0) this->writeGtfs(dir + "/data/gtfs");
+    else this->writeSchedule(dir + "/data/schedule.csv");
+    if (config.congestion > 0) this->writeLinkSpeeds(dir + "/data/link_speeds.csv");
+    this->writeConfig(dir + "/config.toml", dir + "/data");
+}
+
+void Generator::writeStops(const string& path) {
+/**
+ * @brief 產生站點資料 (stops.csv)
+ *
+ * 各站的離峰到站率以對數常態分佈抽樣；早尖峰以路線前段 (往市區) 較高，
+ * 晚尖峰以路線後段較高。下車率沿路線遞增。
+ * 欄位順序與 `System::setupStop` 相同: 名稱、三個時段的到站率 (平均, 標準差; 人/小時)、
+ * 三個時段的下車率 (平均, 標準差)、停靠席位數 (0 表示不限)。
+ *
+ * @param path 輸出檔案路徑
+ */
+    ofstream file(path);
+    if (!file) throw runtime_error("無法開啟輸出檔案 " + path);
+
+    lognormal_distribution<> scale(0, 0.4);
+    file << "name,amArrAvg,amArrSd,pmArrAvg,pmArrSd,offArrAvg,offArrSd,amDropAvg,amDropSd,pmDropAvg,pmDropSd,offDropAvg,offDropSd,berths\n";
+    for (int i = 0; i < config.stops; i++) {
+        double x = config.stops > 1 ? static_cast<double>(i) / (config.stops - 1) : 0; // 站點在路線上的相對位置
+        double base = config.demand * scale(gen);
+        double am = base * (1.8 - 1.2 * x), pm = base * (0.6 + 1.2 * x);
+        double amDrop = 0.001 + 0.004 * x, pmDrop = 0.001 + 0.002 * x, offDrop = 0.0015 + 0.002 * x;
+
+        file << "S" << i << ","
+             << am << "," << am * 0.2 << "," << pm << "," << pm * 0.2 << "," << base << "," << base * 0.2 << ","
+             << amDrop << "," << amDrop * 0.25 << "," << pmDrop << "," << pmDrop * 0.25 << "," << offDrop << "," << offDrop * 0.25 << "," << config.berths << "\n";
+    }
+}
+
+void Generator::writeLinkSpeeds(const string& path) {
+/**
+ * @brief 產生路段速度表 (link_speeds.csv，格式同 `LinkSpeed::load`)
+ *
+ * 每日 96 個 15 分鐘時段。離峰不限制 (空白)；早晚尖峰時段背景車流速度自 25 kph 依 `congestion` 降低，
+ * 各路段的壅塞程度以均勻分佈抽樣，尖峰前後 30 分鐘線性過渡。
+ *
+ * @param path 輸出檔案路徑
+ */
+    ofstream file(path);
+    if (!file) throw runtime_error("無法開啟輸出檔案 " + path);
+
+    const int bins = 96, binSize = 86400 / bins;
+    const vector<pair<int, int>> peaks = { {7 * 3600, 9 * 3600}, {16 * 3600 + 1800, 19 * 3600} };
+    uniform_real_distribution<> severity(0.5, 1.0);
+
+    file << "type,id";
+    for (int b = 0; b < bins; b++) file << "," << setw(2) << setfill('0') << b * binSize / 3600 << setw(2) << b * binSize % 3600 / 60;
+    file << setfill(' ') << "\n";
+    auto writeRow = [&](const char* type, int id) {
+        double drop = config.congestion * severity(gen);
+        file << type << "," << id;
+        for (int b = 0; b < bins; b++) {
+            int t = b * binSize + binSize / 2;
+            double level = 0;  // 壅塞程度 (0 - 1)
+            for (auto [from, to] : peaks) level = max(level, clamp(min(t - from + 1800, to + 1800 - t) / 1800.0, 0.0, 1.0));
+            file << ",";
+            if (level > 0) file << fixed << setprecision(1) << 25 * (1 - drop * level) << defaultfloat;
+        }
+        file << "\n";
+    };
+    for (int i = 0; i < config.stops; i++) writeRow("stop", i);
+    for (int i = 0; i < config.signals; i++) writeRow("signal", i);
+}
+
+string Generator::signalPlan(int index, bool weekend) {
+/**
+ * @brief 產生單一號誌的全日時制字串 (格式同 `Plan::setPhase`)
+ *
+ * 平日分為深夜、清晨、早尖峰、離峰、晚尖峰、晚間、深夜七個時段，尖峰週期較長；
+ * 週末沒有尖峰時段。
+ * 時差依號誌的名目位置以 40 kph 綠波推進計算；由於 `Plan` 會將各時段的時差累加，
+ * 輸出值為相對前一時段的差值。
+ *
+ * @param index 號誌編號
+ * @param weekend 是否為週末時制
+ * @return string 時制字串，例如 "/0000/90/12/0,45/;/0600/120/30/0,62/;..."
+ */
+    const vector<pair<string, int>> periods = weekend
+        ? vector<pair<string, int>>{ {"0000", 90}, {"0700", 120}, {"2300", 90} }
+        : vector<pair<string, int>>{ {"0000", 90}, {"0600", 120}, {"0700", 150}, {"0900", 120}, {"1630", 150}, {"1900", 120}, {"2300", 90} };
+    uniform_real_distribution<> split(0.45, 0.6); // 幹道綠燈比
+    double position = (index + 1) * config.signalDist;
+    double progression = 40 / 3.6;
+
+    string plan;
+    int prevOffset = 0;
+    for (size_t k = 0; k < periods.size(); k++) {
+        int cycle = periods[k].second;
+        int offset = static_cast<int>(position / progression) % cycle;
+        int delta = k ? ((offset - prevOffset) % cycle + cycle) % cycle : offset;
+        int green = static_cast<int>(cycle * split(gen));
+        if (k) plan += ";";
+        plan += "/" + periods[k].first + "/" + to_string(cycle) + "/" + to_string(delta) + "/0," + to_string(green) + "/";
+        prevOffset = offset;
+    }
+    return plan;
+}
+
+void Generator::writeSignals(const string& path) {
+/**
+ * @brief 產生號誌資料 (signals.csv)，欄位: 編號、名稱、時制字串
+ *
+ * 多日情境的時制字串為 "平日時制|週末時制"。
+ * `traffic` 大於 0 時另輸出各路口的一般車流量 (平均值的 0.6 至 1.4 倍) 與飽和流率 (1800 輛/小時)。
+ *
+ * @param path 輸出檔案路徑
+ */
+    ofstream file(path);
+    if (!file) throw runtime_error("無法開啟輸出檔案 " + path);
+
+    uniform_real_distribution<> volume(0.6, 1.4); // 各路口車流量相對於平均值的倍率
+    file << "id,name,plan" << (config.traffic > 0 ? ",volume,saturation" : "") << "\n";
+    for (int i = 0; i < config.signals; i++) {
+        file << i << ",L" << i << "," << this->signalPlan(i, false);
+        if (config.days > 1) file << "|" << this->signalPlan(i, true);
+        if (config.traffic > 0) file << "," << static_cast<int>(config.traffic * volume(gen)) << ",1800";
+        file << "\n";
+    }
+}
+
+void Generator::writeSchedule(const string& path) {
+/**
+ * @brief 產生班表 (schedule.csv)，格式同 `System::readSche`
+ *
+ * 欄位: trial (班表組別), trip (班次編號), departure (發車時間，秒), headway (與前一班的間距，秒)。
+ * 發車間距依常態分佈抽樣並取絕對值，與 `System::setupSche` 相同；多日情境每天由首班車時間重新發車。
+ *
+ * @param path 輸出檔案路徑
+ */
+    ofstream file(path);
+    if (!file) throw runtime_error("無法開啟輸出檔案 " + path);
+
+    int start = stoi(config.startTime.substr(0, 2)) * 3600 + stoi(config.startTime.substr(2, 2)) * 60;
+    normal_distribution<> dist(config.headway * 60, config.headwaySd * 60);
+
+    file << "trial,trip,departure,headway\n";
+    for (int t = 0; t < config.trials; t++) {
+        int trip = 0;
+        for (int day = 0; day < config.days; day++) {
+            int departure = start + day * 86400;
+            for (int i = 0; i < config.trips; i++) {
+                int hdwy = max(1, static_cast<int>(abs(dist(gen)))); // 至少 1 秒，避免班距為 0
+                if (i > 0) departure += hdwy;
+                file << t << "," << trip++ << "," << departure << "," << hdwy << "\n";
+            }
+        }
+    }
+}
+
+void Generator::writeGtfs(const string& dir) {
+/**
+ * @brief 產生 GTFS feed，模擬整個城市的公車網路
+ *
+ * 共 `gtfsRoutes` 條路線，每條路線 `stops` 站、每日 `trips` 班 (發車間距抽樣方式同 `writeSchedule`)，
+ * 站間行駛時間以 `stopDist` 及 25 kph 計算。第 0 條路線的 route_short_name 為 `route`，
+ * 其停靠站名稱與 stops.csv 相同，可直接作為模擬路線的班表；
+ * 路線數大於 1 時，最後一條路線改以 frequencies.txt 定義班距。
+ *
+ * @param dir 輸出目錄 (不存在時自動建立)
+ */
+    filesystem::create_directories(dir);
+    auto open = [&](const string& name) {
+        ofstream file(dir + "/" + name);
+        if (!file) throw runtime_error("無法開啟輸出檔案 " + dir + "/" + name);
+        return file;
+    };
+
+    ofstream agency = open("agency.txt");
+    agency << "agency_id,agency_name,agency_url,agency_timezone\n"
+           << "A,\"Synthetic Transit, Inc.\",https://example.com,Asia/Taipei\n";
+    ofstream calendar = open("calendar.txt");
+    calendar << "service_id,monday,tuesday,wednesday,thursday,friday,saturday,sunday,start_date,end_date\n"
+             << "WK,1,1,1,1,1,1,1,20240101,20241231\n";
+
+    ofstream routes = open("routes.txt"), trips = open("trips.txt"), stops = open("stops.txt");
+    ofstream stopTimes = open("stop_times.txt"), frequencies = open("frequencies.txt");
+    routes << "route_id,agency_id,route_short_name,route_type\n";
+    trips << "route_id,service_id,trip_id,direction_id\n";
+    stops << "stop_id,stop_name,stop_lat,stop_lon\n";
+    stopTimes << "trip_id,arrival_time,departure_time,stop_id,stop_sequence\n";
+    frequencies << "trip_id,start_time,end_time,headway_secs\n";
+
+    auto clock = [](int t) {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", t / 3600, t / 60 % 60, t % 60);
+        return string(buffer);
+    };
+    int start = stoi(config.startTime.substr(0, 2)) * 3600 + stoi(config.startTime.substr(2, 2)) * 60;
+    int link = max(1, static_cast<int>(config.stopDist / (25 / 3.6))); // 站間行駛時間 (秒)
+    normal_distribution<> dist(config.headway * 60, config.headwaySd * 60);
+
+    for (int r = 0; r < config.gtfsRoutes; r++) {
+        string routeId = "R" + to_string(r);
+        routes << routeId << ",A," << (r == 0 ? config.route : to_string(100 + r)) << ",3\n";
+        for (int i = 0; i < config.stops; i++) {
+            stops << routeId << "S" << i << "," << (r == 0 ? "S" + to_string(i) : routeId + "S" + to_string(i))
+                  << "," << 25.0 + r * 0.001 << "," << 121.5 + i * 0.003 << "\n";
+        }
+
+        bool frequencyBased = config.gtfsRoutes > 1 && r == config.gtfsRoutes - 1;
+        int departure = start, tripCount = frequencyBased ? 1 : config.trips;
+        for (int k = 0; k < tripCount; k++) {
+            string tripId = routeId + "T" + to_string(k);
+            if (k > 0) departure += max(1, static_cast<int>(abs(dist(gen)))); // 至少 1 秒，避免重複的發車時刻
+            trips << routeId << ",WK," << tripId << ",0\n";
+            for (int i = 0; i < config.stops; i++) {
+                string t = clock(departure + i * (link + 20));
+                stopTimes << tripId << "," << t << "," << t << "," << routeId << "S" << i << "," << i + 1 << "\n";
+            }
+        }
+        if (frequencyBased) {
+            frequencies << routeId << "T0," << clock(start) << "," << clock(start + config.trips * config.headway * 60)
+                        << "," << static_cast<int>(config.headway * 60) << "\n";
+        }
+    }
+}
+
+void Generator::writeConfig(const string& path, const string& dataDir) {
+/**
+ * @brief 產生對應的設定檔 (config.toml)，班表改由 schedule.csv (或 GTFS feed) 讀取，並關閉事件記錄
+ *
+ * @param path 輸出檔案路徑
+ * @param dataDir 站點、號誌與班表資料目錄
+ */
+    ofstream file(path);
+    if (!file) throw runtime_error("無法開啟輸出檔案 " + path);
+
+    file << "[general]\nscheme = " << config.scheme << "\nroute = \"" << config.route << "\"\nmorningPeak = \"0700-0900\"\neveningPeak = \"1630-1900\"\n"
+         << "dataDir = \"" << dataDir << "\"\n"
+         << (config.simulationSeed >= 0 ? "seed = " + to_string(config.simulationSeed) + "\n\n" : "\n")
+         << "[stop]\ndistAvg = " << config.stopDist << "\ndistSd = " << config.stopDist / 5 << "\n\n"
+         << "[signal]\ndistAvg = " << config.signalDist << "\ndistSd = " << config.signalDist / 8 << "\n\n"
+         << "[schedule]\nstartTime = \"" << config.startTime << "\"\nendTime = \"2359\"\navg = " << config.headway
+         << "\nsd = " << config.headwaySd << "\nshift = " << config.trips << "\ndays = " << config.days
+         << (config.gtfsRoutes > 0 ? "\ngtfs = \"gtfs\"\n\n" : "\nfile = \"schedule.csv\"\ntrial = 0\n\n")
+         << "[velocity]\navg = 25\nsd = 7\nlimit = 40\nlow = 15\novertaking = " << (config.overtaking ? "true" : "false") << "\nminGap = 3\n"
+         << (config.congestion > 0 ? "linkSpeeds = \"link_speeds.csv\"\n\n" : "\n")
+         << "[time]\nTmax = 180\nschemeThreshold = 0.75\n\n"
+         << (config.days > 1 ? "[demand]\ndayFactor = [1.0, 1.0, 1.0, 1.0, 1.05, 0.7, 0.5]\npeakDays = [1, 2, 3, 4, 5]\n\n" : "")
+         << "[output]\nsummary = \"\"\ntrajectory = \"\"\nverbose = false\n";
+}
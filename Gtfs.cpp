@@ -0,0 +1,201 @@
+#include "Gtfs.hpp"
+
+CsvStream::CsvStream(const string& path, bool required) : file(path) {
+/**
+ * @brief 開啟 CSV 檔案並讀取標題列
+ *
+ * @param path 檔案路徑
+ * @param required 檔案是否必須存在
+ * @throws runtime_error 若必要的檔案無法開啟
+ */
+    if (!file) {
+        if (required) throw runtime_error("無法開啟 " + path);
+        return;
+    }
+    if (!this->next()) return;
+    for (auto f : fields) header.emplace_back(f);
+    if (!header.empty() && header[0].starts_with("\xEF\xBB\xBF")) header[0].erase(0, 3); // 去除 UTF-8 BOM
+}
+
+bool CsvStream::next() {
+    if (!file.is_open() || !getline(file, line)) return false;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    this->split();
+    return true;
+}
+
+void CsvStream::split() {
+/**
+ * @brief 將目前列切分為欄位
+ *
+ * 不含雙引號的列 (GTFS 中絕大多數) 直接以 string_view 指向原字串；
+ * 含雙引號的列則去除引號並還原跳脫的 "" 後存放於暫存區。
+ */
+    fields.clear();
+    if (line.find('"') == string::npos) {
+        size_t start = 0;
+        while (true) {
+            size_t comma = line.find(',', start);
+            if (comma == string::npos) {
+                fields.emplace_back(line.data() + start, line.size() - start);
+                return;
+            }
+            fields.emplace_back(line.data() + start, comma - start);
+            start = comma + 1;
+        }
+    }
+
+    unquoted.clear();
+    vector<pair<size_t, size_t>> spans; // 各欄位在暫存區中的 (起點, 長度)
+    size_t start = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') { unquoted += '"'; i++; }
+            else if (c == '"') quoted = false;
+            else unquoted += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            spans.emplace_back(start, unquoted.size() - start);
+            start = unquoted.size();
+        } else {
+            unquoted += c;
+        }
+    }
+    spans.emplace_back(start, unquoted.size() - start);
+    for (auto [begin, length] : spans) fields.emplace_back(unquoted.data() + begin, length);
+}
+
+int CsvStream::column(const string& name) const {
+    auto it = find(header.begin(), header.end(), name);
+    return it == header.end() ? -1 : static_cast<int>(it - header.begin());
+}
+
+string_view CsvStream::field(int index) const {
+    if (index < 0 || static_cast<size_t>(index) >= fields.size()) return {};
+    return fields[index];
+}
+
+Gtfs::Gtfs(const string& dir) : dir(dir) {}
+
+int Gtfs::parseTime(string_view text) {
+/**
+ * @brief 解析 GTFS 時間字串 ("H:MM:SS" 或 "HH:MM:SS"，跨日班次的小時可超過 24)
+ *
+ * @param text 時間字串
+ * @return int 自服務日午夜起算的秒數；空字串或格式錯誤時回傳 -1
+ */
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    int parts[3] = {0, 0, 0}, n = 0;
+    for (size_t i = 0; i < text.size() && n < 3; n++) {
+        auto [ptr, ec] = from_chars(text.data() + i, text.data() + text.size(), parts[n]);
+        if (ec != errc()) return -1;
+        i = ptr - text.data() + 1; // 跳過 ':'
+    }
+    return n == 3 ? parts[0] * 3600 + parts[1] * 60 + parts[2] : -1;
+}
+
+void Gtfs::load(const string& route, int direction, const string& service) {
+/**
+ * @brief 讀取單一路線的發車時間
+ *
+ * 1. routes.txt: 以 route_short_name 或 route_id 比對路線。
+ * 2. trips.txt: 篩選該路線 (及指定方向、服務日) 的班次。
+ * 3. frequencies.txt (可省略): 以班距定義的班次，依 start_time 至 end_time 每 headway_secs 發車一班。
+ * 4. stop_times.txt: 串流讀取，只記錄篩選班次中 stop_sequence 最小者的發車時間，
+ *    並記錄第一個班次的停靠站順序。
+ * 5. stops.txt: 取得代表班次的停靠站名稱。
+ *
+ * @param route 路線 (route_short_name 或 route_id)
+ * @param direction 方向 (direction_id)，-1 表示不篩選
+ * @param service 服務日 (service_id)，空字串表示不篩選
+ * @throws runtime_error 若檔案無法開啟或找不到路線、班次
+ */
+    departures.clear();
+    stopNames.clear();
+    stopTimeRows = 0;
+
+    /* 1. 路線 */
+    unordered_set<string, StringHash, equal_to<>> routeIds;
+    CsvStream routes(dir + "/routes.txt");
+    int routeId = routes.column("route_id"), shortName = routes.column("route_short_name");
+    while (routes.next()) {
+        if (routes.field(shortName) == route || routes.field(routeId) == route) routeIds.emplace(routes.field(routeId));
+    }
+    if (routeIds.empty()) throw runtime_error("GTFS feed 中找不到路線 " + route);
+
+    /* 2. 班次 */
+    unordered_map<string, int, StringHash, equal_to<>> trips; // trip_id -> 班次索引
+    CsvStream tripFile(dir + "/trips.txt");
+    int tripRoute = tripFile.column("route_id"), tripId = tripFile.column("trip_id");
+    int tripDirection = tripFile.column("direction_id"), tripService = tripFile.column("service_id");
+    while (tripFile.next()) {
+        if (routeIds.find(tripFile.field(tripRoute)) == routeIds.end()) continue;
+        if (direction >= 0 && tripDirection >= 0 && tripFile.field(tripDirection) != to_string(direction)) continue;
+        if (!service.empty() && tripFile.field(tripService) != service) continue;
+        trips.emplace(tripFile.field(tripId), trips.size());
+    }
+    if (trips.empty()) throw runtime_error("GTFS feed 中路線 " + route + " 沒有符合條件的班次");
+
+    /* 3. 班距定義的班次 */
+    vector<uint8_t> frequencyBased(trips.size(), 0);
+    CsvStream frequencies(dir + "/frequencies.txt", false);
+    if (frequencies.isOpen()) {
+        int freqTrip = frequencies.column("trip_id"), freqStart = frequencies.column("start_time");
+        int freqEnd = frequencies.column("end_time"), freqHeadway = frequencies.column("headway_secs");
+        while (frequencies.next()) {
+            auto it = trips.find(frequencies.field(freqTrip));
+            if (it == trips.end()) continue;
+            frequencyBased[it->second] = 1;
+            int start = parseTime(frequencies.field(freqStart)), end = parseTime(frequencies.field(freqEnd)), headway = 0;
+            string_view text = frequencies.field(freqHeadway);
+            from_chars(text.data(), text.data() + text.size(), headway);
+            if (start < 0 || end < 0 || headway <= 0) throw runtime_error("frequencies.txt 格式錯誤");
+            for (int t = start; t < end; t += headway) departures.push_back(t);
+        }
+    }
+
+    /* 4. 各班次首站發車時間 (串流處理) */
+    vector<int> first(trips.size(), -1), firstSeq(trips.size(), INT_MAX);
+    vector<pair<int, string>> pattern; // 代表班次 (索引 0) 的 (stop_sequence, stop_id)
+    CsvStream stopTimes(dir + "/stop_times.txt");
+    int stTrip = stopTimes.column("trip_id"), stDeparture = stopTimes.column("departure_time");
+    int stArrival = stopTimes.column("arrival_time"), stStop = stopTimes.column("stop_id"), stSeq = stopTimes.column("stop_sequence");
+    while (stopTimes.next()) {
+        stopTimeRows++;
+        auto it = trips.find(stopTimes.field(stTrip));
+        if (it == trips.end()) continue;
+
+        int index = it->second, seq = 0;
+        string_view text = stopTimes.field(stSeq);
+        from_chars(text.data(), text.data() + text.size(), seq);
+        if (seq < firstSeq[index]) {
+            int time = parseTime(stopTimes.field(stDeparture));
+            if (time < 0) time = parseTime(stopTimes.field(stArrival)); // 部分 feed 只填 arrival_time
+            firstSeq[index] = seq;
+            first[index] = time;
+        }
+        if (index == 0) pattern.emplace_back(seq, stopTimes.field(stStop));
+    }
+    for (size_t i = 0; i < first.size(); i++) {
+        if (!frequencyBased[i] && first[i] >= 0) departures.push_back(first[i]);
+    }
+    sort(departures.begin(), departures.end());
+
+    /* 5. 停靠站名稱 */
+    sort(pattern.begin(), pattern.end());
+    unordered_map<string, int, StringHash, equal_to<>> position; // stop_id -> 停靠順序
+    for (size_t i = 0; i < pattern.size(); i++) position.emplace(pattern[i].second, i);
+    stopNames.assign(pattern.size(), "");
+    CsvStream stops(dir + "/stops.txt");
+    int stopId = stops.column("stop_id"), stopName = stops.column("stop_name");
+    while (stops.next()) {
+        auto it = position.find(stops.field(stopId));
+        if (it != position.end()) stopNames[it->second] = stops.field(stopName);
+    }
+    for (auto& [seq, id] : pattern) {
+        if (stopNames[position[id]].empty()) stopNames[position[id]] = id; // 無名稱時以 stop_id 代替
+    }
+}
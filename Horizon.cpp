@@ -0,0 +1,79 @@
+#include "Horizon.hpp"
+
+double Horizon::rollout(double vol, int hold) {
+/**
+ * @brief 自快照模擬至 last 站，回傳各次到站的班距偏差總和
+ *
+ * 上下客與置站時間的計算與模擬相同 (上車每人 2 秒，車上乘客超過 65% 容量時 2.7 秒，置站不超過 Tmax)；
+ * 抵達 last 之後的車輛不再推進。
+ *
+ * @param vol 決策中的車輛在下一路段的速度 (m/s)
+ * @param hold 決策中的車輛於下一站額外的持車時間 (秒)
+ * @return double 預測的班距偏差
+ */
+    this->rollouts++;
+    this->stopWork.assign(this->stop.begin(), this->stop.end());
+    this->busWork.assign(this->bus.begin(), this->bus.end());
+    HorizonBus& own = this->busWork[0];
+    own.eta = this->now + (this->mileage[this->from + 1] - this->mileage[this->from]) / vol;
+    own.hold += hold;
+
+    double cost = 0;
+    int n = this->busWork.size();
+    while (true) {
+        int pick = -1;
+        for (int i = 0; i < n; i++) {
+            if (this->busWork[i].next <= this->last && (pick < 0 || this->busWork[i].eta < this->busWork[pick].eta)) pick = i;
+        }
+        if (pick < 0) break;
+
+        HorizonBus& b = this->busWork[pick];
+        HorizonStop& s = this->stopWork[b.next - this->first];
+        double t = b.eta;
+        if (s.lastArrive >= 0) {
+            double dev = (t - s.lastArrive - b.headway) / b.headway;
+            cost += dev * dev;
+        }
+
+        /* 上下客 */
+        int dropPax = min(b.pax, static_cast<int>((s.lastArrive >= 0 ? t - s.lastArrive : b.headway) * b.dropRate));
+        int paxRemain = b.pax - dropPax;
+        s.pax += s.rate * (t - s.lastUpdate);
+        s.lastUpdate = t;
+        int boardPax = max(0, min(static_cast<int>(s.pax), this->capacity - paxRemain));
+        int dwellTime = static_cast<int>(boardPax * (b.pax < 0.65 * this->capacity ? 2 : 2.7));
+        b.pax = paxRemain + boardPax;
+        s.pax -= boardPax;
+        s.lastArrive = t;
+
+        /* 駛往下一站 */
+        double departure = t + min(this->Tmax, max(b.hold, dwellTime));
+        b.hold = 0;
+        b.next++;
+        if (b.next <= this->last) b.eta = departure + (this->mileage[b.next] - this->mileage[b.next - 1]) / this->Vavg;
+    }
+    return cost;
+}
+
+HorizonChoice Horizon::choose(double Vlow, double Vlimit, double Vown) {
+/**
+ * @brief 試算不控制 (本次平均速度、不持車) 及速度下限至上限間 speeds 個速度 x holds 個持車時間的組合
+ *
+ * 預測班距偏差相同時保留先試算者 (不控制優先，其次為持車時間較短者)。
+ *
+ * @param Vlow 速度下限 (m/s)
+ * @param Vlimit 速度上限 (m/s)
+ * @param Vown 決策中的車輛本次的平均速度 (m/s)
+ * @return HorizonChoice 預測班距偏差最小的速度與持車時間
+ */
+    double baseline = this->rollout(Vown, 0);
+    HorizonChoice best{ Vown, 0, baseline, baseline };
+    for (int h = 0; h < this->holds; h++) {
+        for (int v = 0; v < this->speeds; v++) {
+            double vol = this->speeds > 1 ? Vlow + (Vlimit - Vlow) * v / (this->speeds - 1) : Vlimit;
+            double cost = this->rollout(vol, h * this->holdStep);
+            if (cost < best.cost - 1e-9) best = { vol, h * this->holdStep, cost, baseline };
+        }
+    }
+    return best;
+}
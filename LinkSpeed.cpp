@@ -0,0 +1,41 @@
+#include "LinkSpeed.hpp"
+#include "Gtfs.hpp"
+
+void LinkSpeed::load(const string& path, int stopAmount, int lightAmount) {
+/**
+ * @brief 讀取路段速度表
+ *
+ * 欄位為 type (stop 或 signal)、id (stops.csv / signals.csv 中的順序編號)，其後為各時段的速度 (kph)。
+ * 時段數由標題列的欄位數決定，須整除一日 (例如 96 欄為 15 分鐘一個時段)，自 00:00 起算並每日重複。
+ * 未列出的路段及空白或 0 的欄位表示該時段不受背景車流限制。
+ *
+ * @param path 檔案路徑
+ * @param stopAmount 站點數量 (號誌路段的索引接在站點之後)
+ * @param lightAmount 號誌數量
+ * @throws runtime_error 若檔案無法開啟、時段數不整除一日或路段不存在
+ */
+    CsvStream csv(path);
+    if (csv.column("type") != 0 || csv.column("id") != 1) throw runtime_error(path + " 的前兩欄必須為 type,id");
+    this->bins = csv.columns() - 2;
+    if (this->bins < 1 || 86400 % this->bins != 0) throw runtime_error(path + " 的時段數 (" + to_string(this->bins) + ") 必須整除一日 86400 秒");
+    this->binSize = 86400 / this->bins;
+    this->speeds.assign(static_cast<size_t>(stopAmount + lightAmount) * this->bins, 0.0f);
+
+    int line = 1;
+    while (csv.next()) {
+        line++;
+        string_view type = csv.field(0);
+        if (type.empty()) continue;  // 空白列
+        int id = stoi(string(csv.field(1)));
+        int key;
+        if (type == "stop" && id >= 0 && id < stopAmount) key = id;
+        else if (type == "signal" && id >= 0 && id < lightAmount) key = stopAmount + id;
+        else throw runtime_error(path + " 第 " + to_string(line) + " 列: 路段 " + string(type) + " " + to_string(id) + " 不存在");
+
+        float* row = &this->speeds[static_cast<size_t>(key) * this->bins];
+        for (int b = 0; b < this->bins; b++) {
+            string_view field = csv.field(b + 2);
+            if (!field.empty()) row[b] = stof(string(field)) / 3.6f;  // kph -> m/s
+        }
+    }
+}
@@ -0,0 +1,320 @@
+#include "Metrics.hpp"
+#include "Checkpoint.hpp"
+
+void Welford::add(double x) {
+/**
+ * @brief 以 Welford 演算法加入一筆樣本，單次掃描更新平均值與平方差和
+ *
+ * @param x 樣本值
+ */
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+}
+
+void Welford::merge(const Welford& other) {
+/**
+ * @brief 合併另一個累積器 (Chan 平行演算法)，用於合併多次重複實驗的結果
+ *
+ * @param other 另一個累積器
+ */
+    if (other.n == 0) return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    long long total = n + other.n;
+    double delta = other.mean - mean;
+    mean += delta * other.n / total;
+    m2 += other.m2 + delta * delta * n * other.n / total;
+    n = total;
+}
+
+double Welford::variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+
+double Welford::sd() const { return sqrt(variance()); }
+
+double Welford::cv() const { return mean ? sd() / mean : 0.0; }
+
+double Welford::secondMoment() const { return n ? m2 / n + mean * mean : 0.0; }
+
+void Metrics::resize(int stopAmount, int busAmount, double compression) {
+/**
+ * @brief 依站點數量與車輛數量配置所有累積器，模擬過程中不再配置記憶體
+ *
+ * @param stopAmount 站點數量
+ * @param busAmount 車輛數量
+ * @param compression 分位數 sketch 的壓縮參數，決定每個 sketch 的記憶體上限
+ */
+    stopHeadway.assign(stopAmount, Welford());
+    stopScheHeadway.assign(stopAmount, Welford());
+    stopLoad.assign(stopAmount, Welford());
+    busHeadway.assign(busAmount, Welford());
+    busLoad.assign(busAmount, Welford());
+    busBunching.assign(busAmount, Welford());
+    dispatchTime.assign(busAmount, -1);
+    busSpeed.assign(busAmount, 0.0);
+    episodeStart.assign(busAmount, make_pair(-1, -1));
+    stopHeadwayDigest.assign(stopAmount, TDigest(compression));
+    stopDwellDigest.assign(stopAmount, TDigest(compression));
+    headwayDigest = TDigest(compression);
+    dwellDigest = TDigest(compression);
+}
+
+void Metrics::recordDispatch(int busID, int time) {
+    dispatchTime[busID] = time;
+}
+
+void Metrics::recordHeadway(int stopID, int busID, double actual, double scheduled) {
+/**
+ * @brief 記錄某車於某站的實際班距與表定班距
+ *
+ * @param stopID 站點編號
+ * @param busID 公車編號
+ * @param actual 與前車抵達該站的時間差 (秒)
+ * @param scheduled 表定發車間距 (秒)
+ */
+    stopHeadway[stopID].add(actual);
+    stopScheHeadway[stopID].add(scheduled);
+    busHeadway[busID].add(actual);
+    allHeadway.add(actual);
+    stopHeadwayDigest[stopID].add(actual);
+    headwayDigest.add(actual);
+}
+
+void Metrics::recordDwell(int stopID, int dwell) {
+/**
+ * @brief 記錄公車在某站因乘客上下車所需的置站時間
+ *
+ * @param stopID 站點編號
+ * @param dwell 置站時間 (秒)
+ */
+    stopDwellDigest[stopID].add(dwell);
+    dwellDigest.add(dwell);
+}
+
+void Metrics::recordLoad(int stopID, int busID, int pax, int capacity) {
+/**
+ * @brief 記錄公車離站時的載客率 (車上乘客數 / 容量)
+ */
+    double factor = static_cast<double>(pax) / capacity;
+    stopLoad[stopID].add(factor);
+    busLoad[busID].add(factor);
+    allLoad.add(factor);
+}
+
+void Metrics::recordBunching(int busID, int stopID, int time, bool bunched) {
+/**
+ * @brief 記錄公車在某站的連班狀態，並統計連班事件的次數與持續長度
+ *
+ * 連班狀態由否轉是時開啟一次連班事件；由是轉否 (或抵達終點) 時結束該事件，
+ * 並記錄其持續的站數與秒數。
+ *
+ * @param busID 公車編號
+ * @param stopID 站點編號
+ * @param time 當前時間 (秒)
+ * @param bunched 是否處於連班狀態
+ */
+    auto& start = episodeStart[busID];
+    if (bunched && start.first < 0) {
+        start = make_pair(stopID, time);
+    } else if (!bunched && start.first >= 0) {
+        episodes++;
+        episodeStops.add(stopID - start.first);
+        episodeSeconds.add(time - start.second);
+        busBunching[busID].add(time - start.second);
+        start = make_pair(-1, -1);
+    }
+}
+
+void Metrics::recordTrip(int busID, int stopID, int time, int distance) {
+/**
+ * @brief 記錄公車抵達終點，計算營運速度並結束進行中的連班事件
+ *
+ * @param busID 公車編號
+ * @param stopID 終點站編號
+ * @param time 抵達終點的時間 (秒)
+ * @param distance 全程里程 (公尺)
+ */
+    this->recordBunching(busID, stopID, time, false);
+    if (dispatchTime[busID] >= 0 && time > dispatchTime[busID]) {
+        busSpeed[busID] = distance / static_cast<double>(time - dispatchTime[busID]) * 3.6;
+        tripSpeed.add(busSpeed[busID]);
+    }
+}
+
+void Metrics::merge(const Metrics& other) {
+/**
+ * @brief 合併另一次模擬的績效指標 (兩者需有相同的站點數)
+ *
+ * 各站指標逐站合併；各車指標以車輛編號對應合併，車輛數不同時以較多者為準。
+ */
+    if (stopHeadway.size() != other.stopHeadway.size()) {
+        throw runtime_error("合併績效指標失敗: 站點數量不一致");
+    }
+    for (size_t i = 0; i < stopHeadway.size(); i++) {
+        stopHeadway[i].merge(other.stopHeadway[i]);
+        stopScheHeadway[i].merge(other.stopScheHeadway[i]);
+        stopLoad[i].merge(other.stopLoad[i]);
+        stopHeadwayDigest[i].merge(other.stopHeadwayDigest[i]);
+        stopDwellDigest[i].merge(other.stopDwellDigest[i]);
+    }
+    if (busHeadway.size() < other.busHeadway.size()) {
+        busHeadway.resize(other.busHeadway.size());
+        busLoad.resize(other.busLoad.size());
+        busBunching.resize(other.busBunching.size());
+        dispatchTime.resize(other.dispatchTime.size(), -1);
+        busSpeed.resize(other.busSpeed.size(), 0.0);
+        episodeStart.resize(other.episodeStart.size(), make_pair(-1, -1));
+    }
+    for (size_t i = 0; i < other.busHeadway.size(); i++) {
+        busHeadway[i].merge(other.busHeadway[i]);
+        busLoad[i].merge(other.busLoad[i]);
+        busBunching[i].merge(other.busBunching[i]);
+    }
+    allHeadway.merge(other.allHeadway);
+    allLoad.merge(other.allLoad);
+    episodeStops.merge(other.episodeStops);
+    episodeSeconds.merge(other.episodeSeconds);
+    tripSpeed.merge(other.tripSpeed);
+    berthWaiting.merge(other.berthWaiting);
+    episodes += other.episodes;
+    headwayDigest.merge(other.headwayDigest);
+    dwellDigest.merge(other.dwellDigest);
+}
+
+double Metrics::excessWaitTime(int stopID) const {
+/**
+ * @brief 計算單站的額外等候時間 (Excess Wait Time)
+ *
+ * 假設乘客隨機到站，平均等候時間為 E[H^2] / (2E[H])。
+ * 額外等候時間 = 實際平均等候時間 - 表定平均等候時間。
+ *
+ * @param stopID 站點編號
+ * @return double 額外等候時間 (秒)，樣本不足時回傳 0
+ */
+    const Welford& actual = stopHeadway[stopID];
+    const Welford& scheduled = stopScheHeadway[stopID];
+    if (actual.n == 0 || actual.mean <= 0 || scheduled.mean <= 0) return 0.0;
+    double awt = actual.secondMoment() / (2 * actual.mean);
+    double swt = scheduled.secondMoment() / (2 * scheduled.mean);
+    return awt - swt;
+}
+
+double Metrics::excessWaitTime() const {
+/**
+ * @brief 計算全線的額外等候時間，以各站樣本數加權平均
+ */
+    double total = 0;
+    long long count = 0;
+    for (size_t i = 0; i < stopHeadway.size(); i++) {
+        total += this->excessWaitTime(i) * stopHeadway[i].n;
+        count += stopHeadway[i].n;
+    }
+    return count ? total / count : 0.0;
+}
+
+void Metrics::writeWelford(ostream& os, const Welford& w) {
+    os << "{\"n\":" << w.n << ",\"mean\":" << w.mean << ",\"sd\":" << w.sd() << ",\"cv\":" << w.cv() << "}";
+}
+
+void Metrics::writeQuantiles(ostream& os, const TDigest& d) {
+    if (d.count() == 0) {
+        os << "null";
+        return;
+    }
+    os << "{\"p50\":" << d.quantile(0.5) << ",\"p90\":" << d.quantile(0.9) << ",\"p99\":" << d.quantile(0.99) << "}";
+}
+
+void Metrics::writeJson(ostream& os) const {
+/**
+ * @brief 以 JSON 物件輸出所有績效指標 (全線、各站、各車)
+ *
+ * @param os 輸出串流
+ */
+    os << "{\"headway\":";
+    writeWelford(os, allHeadway);
+    os << ",\"headwayPercentiles\":";
+    writeQuantiles(os, headwayDigest);
+    os << ",\"dwellPercentiles\":";
+    writeQuantiles(os, dwellDigest);
+    os << ",\"excessWaitTime\":" << this->excessWaitTime();
+    os << ",\"loadFactor\":";
+    writeWelford(os, allLoad);
+    os << ",\"commercialSpeed\":";
+    writeWelford(os, tripSpeed);
+    os << ",\"bunching\":{\"episodes\":" << episodes << ",\"stops\":";
+    writeWelford(os, episodeStops);
+    os << ",\"seconds\":";
+    writeWelford(os, episodeSeconds);
+    os << "}";
+    os << ",\"berthWait\":";
+    writeWelford(os, berthWaiting);
+
+    /* 各站指標 */
+    os << ",\"stops\":[";
+    for (size_t i = 0; i < stopHeadway.size(); i++) {
+        if (i) os << ",";
+        os << "{\"id\":" << i << ",\"headway\":";
+        writeWelford(os, stopHeadway[i]);
+        os << ",\"headwayPercentiles\":";
+        writeQuantiles(os, stopHeadwayDigest[i]);
+        os << ",\"dwellPercentiles\":";
+        writeQuantiles(os, stopDwellDigest[i]);
+        os << ",\"excessWaitTime\":" << this->excessWaitTime(i) << ",\"loadFactor\":";
+        writeWelford(os, stopLoad[i]);
+        os << "}";
+    }
+
+    /* 各車指標 */
+    os << "],\"buses\":[";
+    for (size_t i = 0; i < busHeadway.size(); i++) {
+        if (i) os << ",";
+        os << "{\"id\":" << i << ",\"headway\":";
+        writeWelford(os, busHeadway[i]);
+        os << ",\"loadFactor\":";
+        writeWelford(os, busLoad[i]);
+        os << ",\"bunching\":";
+        writeWelford(os, busBunching[i]);
+        os << ",\"commercialSpeed\":" << busSpeed[i] << "}";
+    }
+    os << "]}";
+}
+
+void Metrics::save(CheckpointWriter& out) const {
+/**
+ * @brief 將所有累積器寫入檢查點
+ */
+    for (auto* v : { &stopHeadway, &stopScheHeadway, &stopLoad, &busHeadway, &busLoad, &busBunching }) out.put(*v);
+    out.put(dispatchTime);
+    out.put(busSpeed);
+    out.put(episodeStart);
+    for (auto* w : { &allHeadway, &allLoad, &episodeStops, &episodeSeconds, &tripSpeed, &berthWaiting }) out.put(*w);
+    out.put(episodes);
+    out.put(stopHeadwayDigest.size());
+    for (auto& d : stopHeadwayDigest) d.save(out);
+    for (auto& d : stopDwellDigest) d.save(out);
+    headwayDigest.save(out);
+    dwellDigest.save(out);
+}
+
+void Metrics::load(CheckpointReader& in) {
+/**
+ * @brief 自檢查點讀回所有累積器 (覆蓋 resize 配置的內容)
+ */
+    for (auto* v : { &stopHeadway, &stopScheHeadway, &stopLoad, &busHeadway, &busLoad, &busBunching }) in.get(*v);
+    in.get(dispatchTime);
+    in.get(busSpeed);
+    in.get(episodeStart);
+    for (auto* w : { &allHeadway, &allLoad, &episodeStops, &episodeSeconds, &tripSpeed, &berthWaiting }) in.get(*w);
+    in.get(episodes);
+    size_t stops;
+    in.get(stops);
+    stopHeadwayDigest.resize(stops);
+    stopDwellDigest.resize(stops);
+    for (auto& d : stopHeadwayDigest) d.load(in);
+    for (auto& d : stopDwellDigest) d.load(in);
+    headwayDigest.load(in);
+    dwellDigest.load(in);
+}
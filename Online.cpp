@@ -0,0 +1,362 @@
+#include "Online.hpp"
+#include "Gtfs.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stopping = 0; // 收到 SIGINT / SIGTERM 後結束服務
+
+static void onSignal(int) { stopping = 1; }
+
+Online::Online(System& system, const toml::table& config) {
+/**
+ * @brief 讀取 [online] 設定: socket (Unix domain socket 路徑，"-" 表示標準輸入 / 輸出)、
+ *        timeout (車輛無事件多久後視為結束營運，預設 1800 秒)
+ *
+ * @param system 已初始化的系統 (站點里程、控制參數)
+ * @param config 設定
+ * @throws runtime_error 若 timeout 不為正值
+ */
+    this->socketPath = config["online"]["socket"].value_or("");
+    this->timeout = config["online"]["timeout"].value_or(1800);
+    if (this->timeout <= 0) throw runtime_error("錯誤: 'online.timeout' 必須大於 0");
+
+    this->stops = system.getStopMileages();
+    this->advisor = system.getAdvisor();
+    this->Vavg = system.getAvgSpeed();
+    this->Tmax = system.getTmax();
+    this->scheduledHeadway = system.getScheduledHeadway();
+    this->dwell.assign(this->stops.size(), Welford());
+}
+
+/* 一則訊息的欄位 (指向原始字串，不複製) */
+struct Message {
+    string_view type, bus, time, stop;
+};
+
+static Message parseMessage(string_view line) {
+/**
+ * @brief 解析單層 JSON 物件，取出 type、bus、stop、time 欄位 (其他欄位略過)
+ *
+ * 值可為字串、數值或布林值；不支援巢狀物件、陣列及字串中的跳脫字元。
+ *
+ * @param line 一行訊息
+ * @throws runtime_error 若不是單層 JSON 物件
+ */
+    Message message;
+    size_t i = 0, n = line.size();
+    auto skip = [&]() { while (i < n && isspace(static_cast<unsigned char>(line[i]))) i++; };
+    auto text = [&]() {
+        if (i >= n || line[i] != '"') throw runtime_error("預期字串");
+        size_t begin = ++i;
+        while (i < n && line[i] != '"') {
+            if (line[i] == '\\') throw runtime_error("不支援跳脫字元");
+            i++;
+        }
+        if (i >= n) throw runtime_error("字串未結束");
+        return line.substr(begin, i++ - begin);
+    };
+
+    skip();
+    if (i >= n || line[i++] != '{') throw runtime_error("訊息必須為 JSON 物件");
+    skip();
+    if (i < n && line[i] == '}') return message;
+    while (true) {
+        skip();
+        string_view key = text();
+        skip();
+        if (i >= n || line[i++] != ':') throw runtime_error("欄位缺少 ':'");
+        skip();
+        string_view value;
+        if (i < n && line[i] == '"') {
+            value = text();
+        } else {
+            size_t begin = i;
+            while (i < n && line[i] != ',' && line[i] != '}' && !isspace(static_cast<unsigned char>(line[i]))) i++;
+            value = line.substr(begin, i - begin);
+            if (value.empty() || value[0] == '{' || value[0] == '[') throw runtime_error("不支援巢狀的值");
+        }
+        if (key == "type") message.type = value;
+        else if (key == "bus") message.bus = value;
+        else if (key == "stop") message.stop = value;
+        else if (key == "time") message.time = value;
+        skip();
+        if (i < n && line[i] == ',') { i++; continue; }
+        if (i < n && line[i] == '}') return message;
+        throw runtime_error("物件未結束");
+    }
+}
+
+static void append(string& out, double value, int precision) {
+    if (!isfinite(value)) { // JSON 沒有 NaN (例如尚未處理任何訊息時的延遲分位數)
+        out += "null";
+        return;
+    }
+    char buffer[32];
+    out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), value, chars_format::fixed, precision).ptr);
+}
+
+static void append(string& out, long long value) {
+    char buffer[24];
+    out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+string Online::handle(string_view line) {
+/**
+ * @brief 處理一則訊息: 更新狀態並產生回覆；格式錯誤時回覆 {"error":"..."}，不影響其他車輛的狀態
+ *
+ * @param line 一行訊息 (不含換行)
+ * @return string 回覆 (不含換行)
+ */
+    auto start = chrono::steady_clock::now();
+    string reply;
+    try {
+        Message message = parseMessage(line);
+        if (message.type == "stats") {
+            reply = "{\"messages\":";
+            append(reply, this->messages);
+            reply += ",\"errors\":";
+            append(reply, this->errors);
+            reply += ",\"buses\":";
+            append(reply, static_cast<long long>(this->buses.size()));
+            reply += ",\"p50\":";
+            append(reply, this->latency.quantile(0.5), 1);
+            reply += ",\"p99\":";
+            append(reply, this->latency.quantile(0.99), 1);
+            reply += ",\"max\":";
+            append(reply, this->latency.quantile(1), 1);
+            reply += "}";
+        } else {
+            double time = -1;
+            int stop = -1;
+            if (message.time.find(':') != string_view::npos) {
+                time = Gtfs::parseTime(message.time);
+            } else {
+                from_chars(message.time.data(), message.time.data() + message.time.size(), time);
+            }
+            from_chars(message.stop.data(), message.stop.data() + message.stop.size(), stop);
+            if (message.bus.empty()) throw runtime_error("缺少 bus 欄位");
+            if (time < 0) throw runtime_error("缺少或錯誤的 time 欄位");
+            if (stop < 0 || stop >= static_cast<int>(this->stops.size())) throw runtime_error("缺少或錯誤的 stop 欄位");
+
+            int now = static_cast<int>(time);
+            if (now >= this->lastSweep + this->timeout) { // 清除逾時的車輛
+                erase_if(this->buses, [&](const auto& entry) { return entry.second.time < now - this->timeout; });
+                this->lastSweep = now;
+            }
+            string id(message.bus);
+            if (message.type == "arrive") this->arrive(id, stop, now, reply);
+            else if (message.type == "depart") this->depart(id, stop, now, reply);
+            else throw runtime_error("未知的 type: " + string(message.type));
+        }
+    } catch (const exception& ex) {
+        this->errors++;
+        string text = ex.what();
+        replace(text.begin(), text.end(), '"', '\'');
+        reply = "{\"error\":\"" + text + "\"}";
+    }
+    this->messages++;
+    this->latency.add(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    return reply;
+}
+
+void Online::arrive(const string& id, int stop, int time, string& reply) {
+/**
+ * @brief 到站: 記錄到站時間，回覆本站的持車時間 (上一站離站時的建議及後車要求的等候，以 Tmax 為上限)
+ */
+    auto [it, created] = this->buses.try_emplace(id);
+    Bus& bus = it->second;
+    if (created) bus.headway = this->scheduledHeadway;
+    int hold = min(this->Tmax, bus.hold);
+    bus.stop = stop;
+    bus.atStop = true;
+    bus.time = time;
+    bus.vol = 0;
+    bus.hold = 0;
+
+    reply = "{\"bus\":\"" + id + "\",\"stop\":";
+    append(reply, stop);
+    reply += ",\"hold\":";
+    append(reply, hold);
+    reply += "}";
+}
+
+void Online::depart(const string& id, int stop, int time, string& reply) {
+/**
+ * @brief 離站: 以其他車輛目前的推估位置評估控制策略，回覆建議速度與下一站的持車時間
+ *
+ * 前車為推估位置在本站之後最近的車輛；下一站的置站時間以該站至今的平均實際置站時間預估。
+ * 速度受上限限制時，前車的下一次到站增加對應的持車時間。
+ */
+    auto [it, created] = this->buses.try_emplace(id);
+    Bus& bus = it->second;
+    if (created) bus.headway = this->scheduledHeadway;
+    if (bus.atStop && bus.stop == stop) this->dwell[stop].add(time - bus.time);
+    if (stop == 0) {
+        bus.headway = this->lastDispatch >= 0 ? time - this->lastDispatch : this->scheduledHeadway;
+        this->lastDispatch = time;
+    }
+
+    Advice advice{ this->Vavg, 0 };
+    if (stop + 1 < static_cast<int>(this->stops.size())) {
+        Bus* leader = nullptr;
+        double leaderAt = 0;
+        for (auto& [other, state] : this->buses) {
+            if (&state == &bus) continue;
+            double at = this->position(state, time);
+            if (at > this->stops[stop] && (!leader || at < leaderAt)) {
+                leader = &state;
+                leaderAt = at;
+            }
+        }
+        optional<double> distance;
+        if (leader) distance = leaderAt - this->stops[stop];
+        int expected = this->dwell[stop + 1].n ? static_cast<int>(this->dwell[stop + 1].mean) : 0;
+        advice = this->advisor.advise(this->Vavg, bus.headway, expected, distance);
+        if (advice.adjust == Advice::TooFar) leader->hold += static_cast<int>(advice.leaderHold);
+        this->advised++;
+        this->bunched += advice.bunching;
+    }
+    int hold = min(this->Tmax, advice.dwell);
+
+    reply = "{\"bus\":\"" + id + "\",\"stop\":";
+    append(reply, stop);
+    reply += ",\"speed\":";
+    append(reply, advice.vol * 3.6, 1);
+    reply += ",\"hold\":";
+    append(reply, hold);
+    reply += advice.bunching ? ",\"bunching\":true}" : ",\"bunching\":false}";
+
+    if (stop + 1 >= static_cast<int>(this->stops.size())) { // 駛離終點站
+        this->buses.erase(it);
+        return;
+    }
+    bus.stop = stop;
+    bus.atStop = false;
+    bus.time = time;
+    bus.vol = advice.vol;
+    bus.hold = advice.dwell;
+}
+
+double Online::position(const Bus& bus, int now) const {
+/**
+ * @brief 推估車輛目前的里程: 停在站點時為該站里程，行駛中以建議速度推進 (不超過下一站)
+ */
+    double at = this->stops[bus.stop];
+    if (bus.atStop || bus.stop + 1 >= static_cast<int>(this->stops.size())) return at;
+    return min<double>(at + bus.vol * (now - bus.time), this->stops[bus.stop + 1]);
+}
+
+void Online::serve() {
+    if (this->socketPath == "-") this->serveStream();
+    else this->serveSocket();
+}
+
+void Online::serveStream() {
+/**
+ * @brief 標準輸入 / 輸出模式: 逐行讀取訊息，每則回覆後立即寫出 (供管線串接)
+ */
+    string line;
+    while (getline(cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        string reply = this->handle(line);
+        reply += '\n';
+        fwrite(reply.data(), 1, reply.size(), stdout);
+        fflush(stdout);
+    }
+}
+
+void Online::serveSocket() {
+/**
+ * @brief Unix domain socket 模式: 以 poll 同時服務多個連線，每個連線的訊息依序處理並回覆
+ *
+ * 所有連線共用同一份車輛狀態；收到 SIGINT / SIGTERM 後關閉連線並移除 socket 檔案。
+ *
+ * @throws runtime_error 若無法建立或監聽 socket
+ */
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->socketPath.size() >= sizeof(address.sun_path)) throw runtime_error("錯誤: 'online.socket' 路徑過長");
+    memcpy(address.sun_path, this->socketPath.c_str(), this->socketPath.size() + 1);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) throw runtime_error("錯誤: 無法建立 socket");
+    unlink(this->socketPath.c_str());
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(server, 16) < 0) {
+        close(server);
+        throw runtime_error("錯誤: 無法監聽 " + this->socketPath + " (" + strerror(errno) + ")");
+    }
+
+    struct sigaction action{};
+    action.sa_handler = onSignal; // 不設定 SA_RESTART，使 poll 被訊號中斷後即可結束
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    cerr << "Listening on " << this->socketPath << "\n";
+
+    vector<pollfd> fds = { { server, POLLIN, 0 } };
+    vector<string> pending(1); // 各連線尚未收到換行的部分訊息
+    vector<char> chunk(1 << 16);
+    while (!stopping) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(server, nullptr, nullptr);
+            if (client >= 0) {
+                fds.push_back({ client, POLLIN, 0 });
+                pending.emplace_back();
+            }
+        }
+        for (size_t c = 1; c < fds.size(); c++) {
+            if (!fds[c].revents) continue;
+            ssize_t n = read(fds[c].fd, chunk.data(), chunk.size());
+            if (n <= 0) {
+                close(fds[c].fd);
+                fds[c].fd = -1;
+                continue;
+            }
+            string& buffer = pending[c];
+            buffer.append(chunk.data(), n);
+            string out;
+            size_t begin = 0;
+            for (size_t end; (end = buffer.find('\n', begin)) != string::npos; begin = end + 1) {
+                string_view line(buffer.data() + begin, end - begin);
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (line.empty()) continue;
+                out += this->handle(line);
+                out += '\n';
+            }
+            buffer.erase(0, begin);
+            for (size_t sent = 0; sent < out.size();) {
+                ssize_t w = send(fds[c].fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+                if (w <= 0) { // 連線已關閉
+                    close(fds[c].fd);
+                    fds[c].fd = -1;
+                    break;
+                }
+                sent += w;
+            }
+        }
+        for (size_t c = fds.size(); c-- > 1;) {
+            if (fds[c].fd >= 0) continue;
+            fds.erase(fds.begin() + c);
+            pending.erase(pending.begin() + c);
+        }
+    }
+    for (auto& fd : fds) close(fd.fd);
+    unlink(this->socketPath.c_str());
+}
+
+void Online::report() const {
+    cerr << ">>> Online advisory <<<\n";
+    cerr << "Messages: " << this->messages << " (" << this->errors << " errors), departures advised: " << this->advised
+         << ", flagged as bunching: " << this->bunched << ", active buses: " << this->buses.size() << "\n";
+    if (this->messages > 0) {
+        cerr << fixed << setprecision(1) << "Latency: p50 " << this->latency.quantile(0.5) << " us, p99 "
+             << this->latency.quantile(0.99) << " us, max " << this->latency.quantile(1) << " us\n" << defaultfloat;
+    }
+}
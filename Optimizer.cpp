@@ -0,0 +1,229 @@
+#include "Optimizer.hpp"
+#include "Metrics.hpp"
+
+Optimizer::Optimizer(const string& configPath) {
+/**
+ * @brief 讀取設定檔中的最佳化設定
+ *
+ * [optimize] 區段: evaluations (候選評估次數上限)、runs (每個候選的重複次數)、threads、objective (Outcome 的欄位名稱，
+ * 預設 headwayDeviation)、tolerance (預設 0.001)、at / day (分支時刻，同 [compare])、output (逐次評估結果 CSV)，
+ * 以及 [optimize.parameters] 中各參數的搜尋範圍，例如 time = { schemeThreshold = [0.3, 1.2] }。
+ *
+ * @param configPath 設定檔路徑
+ * @throws runtime_error 若沒有參數、範圍格式錯誤、參數不是可連續取值的控制參數或目標值不存在
+ */
+    this->config = toml::parse_file(configPath);
+    this->evaluations = this->config["optimize"]["evaluations"].value_or(60);
+    this->runs = max(1, this->config["optimize"]["runs"].value_or(8));
+    this->threads = max(1, this->config["optimize"]["threads"].value_or(1));
+    this->tolerance = this->config["optimize"]["tolerance"].value_or(0.001);
+    this->outputPath = this->config["optimize"]["output"].value_or("");
+    if (auto at = this->config["optimize"]["at"].value<string>()) {
+        this->forkAt = System::time2Seconds(*at) + (this->config["optimize"]["day"].value_or(1) - 1) * 86400;
+    }
+    auto seed = this->config["general"]["seed"].value<int64_t>();
+    this->baseSeed = seed ? static_cast<uint64_t>(*seed) : random_device{}();
+
+    string objectiveName = this->config["optimize"]["objective"].value_or("headwayDeviation");
+    auto name = find(Outcome::names.begin(), Outcome::names.end(), objectiveName);
+    if (name == Outcome::names.end()) throw runtime_error("錯誤: 'optimize.objective' 必須為 Outcome 的欄位 (例如 headwayDeviation)");
+    this->objective = name - Outcome::names.begin();
+
+    if (auto table = this->config["optimize"]["parameters"].as_table()) {
+        for (auto& [section, keys] : *table) {
+            if (!keys.is_table()) throw runtime_error("錯誤: 'optimize.parameters." + string(section.str()) + "' 必須為表格");
+            for (auto& [key, range] : *keys.as_table()) {
+                Parameter parameter;
+                parameter.key = string(section.str()) + "." + string(key.str());
+                if (!System::isContinuousControl(parameter.key)) {
+                    throw runtime_error("錯誤: 參數 '" + parameter.key + "' 不是可連續取值的控制參數 "
+                                        "(time.schemeThreshold、time.Tmax、velocity.limit 或 velocity.low)");
+                }
+                auto* bounds = range.as_array();
+                if (!bounds || bounds->size() != 2 || !(*bounds)[0].value<double>() || !(*bounds)[1].value<double>()) {
+                    throw runtime_error("錯誤: 參數 '" + parameter.key + "' 的範圍必須為 [下限, 上限]");
+                }
+                parameter.low = *(*bounds)[0].value<double>();
+                parameter.high = *(*bounds)[1].value<double>();
+                if (parameter.low >= parameter.high) throw runtime_error("錯誤: 參數 '" + parameter.key + "' 的下限必須小於上限");
+                parameter.initial = clamp(this->config[section.str()][key.str()].value_or((parameter.low + parameter.high) / 2),
+                                          parameter.low, parameter.high);
+                this->parameters.push_back(parameter);
+            }
+        }
+    }
+    if (this->parameters.empty()) throw runtime_error("錯誤: 最佳化至少需要一個 [optimize.parameters] 參數");
+}
+
+vector<double> Optimizer::values(const vector<double>& point) const {
+    vector<double> result(point.size());
+    for (size_t i = 0; i < point.size(); i++) {
+        const Parameter& p = this->parameters[i];
+        result[i] = p.low + (p.high - p.low) * point[i];
+    }
+    return result;
+}
+
+vector<vector<double>> Optimizer::evaluate(const vector<vector<double>>& points) {
+/**
+ * @brief 平行評估一批候選: 每個 (候選, 重複實驗) 自該次的分支狀態 fork 並套用參數後模擬，工作依序分配給各執行緒
+ *
+ * @param points 候選 (單位化座標)
+ * @return vector<vector<double>> 各候選各次重複實驗的目標值
+ */
+    int tasks = points.size() * this->runs;
+    vector<vector<double>> results(points.size(), vector<double>(this->runs));
+    vector<vector<double>> settings;
+    for (auto& point : points) settings.push_back(this->values(point));
+
+    Experiment::parallelFor(this->threads, tasks, [&](long long k, int) {
+        int p = k / this->runs, r = k % this->runs;
+        auto system = this->bases[r]->fork();
+        for (size_t i = 0; i < this->parameters.size(); i++) system->setControl(this->parameters[i].key, settings[p][i]);
+        system->simulation();
+        results[p][r] = Outcome::of(*system).values[this->objective];
+        return true;
+    });
+
+    if (this->output.isOpen()) {
+        for (size_t p = 0; p < points.size(); p++) {
+            Welford stat;
+            for (double v : results[p]) stat.add(v);
+            this->output << this->evaluated + static_cast<int>(p);
+            for (double v : settings[p]) this->output << ',' << v;
+            this->output << ',' << stat.mean << ',' << stat.sd() << '\n';
+        }
+    }
+    this->evaluated += points.size();
+    return results;
+}
+
+void Optimizer::optimize() {
+/**
+ * @brief 以 Nelder-Mead 單體法在單位化的參數空間 (各參數範圍對應至 [0, 1]) 搜尋目標值最小的參數組
+ *
+ * 起始單體為設定檔中的值及沿各軸移動 0.25 的點；超出範圍的候選截斷至邊界。
+ * 評估次數達 evaluations 或單體大小低於 tolerance 時停止，最後以配對差值比較最佳參數組與起始值。
+ */
+    auto start = chrono::steady_clock::now();
+    int d = this->parameters.size();
+
+    /* 各重複實驗只初始化一次 (平行) */
+    this->bases.resize(this->runs);
+    Experiment::parallelFor(this->threads, this->runs, [&](long long r, int) {
+        this->bases[r] = Experiment::prepare(this->config, this->baseSeed + r, this->forkAt);
+        return true;
+    });
+
+    if (!this->outputPath.empty()) {
+        this->output.open(this->outputPath);
+        this->output << "evaluation";
+        for (auto& p : this->parameters) this->output << ',' << p.key;
+        this->output << ",mean,sd\n";
+    }
+
+    auto mean = [](const vector<double>& v) { return accumulate(v.begin(), v.end(), 0.0) / v.size(); };
+    auto clip = [](vector<double> x) {
+        for (auto& v : x) v = clamp(v, 0.0, 1.0);
+        return x;
+    };
+    auto toward = [&](const vector<double>& from, const vector<double>& to, double step) { // from + step * (to - from)
+        vector<double> x(d);
+        for (int i = 0; i < d; i++) x[i] = from[i] + step * (to[i] - from[i]);
+        return clip(x);
+    };
+
+    /* 起始單體 */
+    vector<vector<double>> simplex(d + 1, vector<double>(d));
+    for (int i = 0; i < d; i++) {
+        const Parameter& p = this->parameters[i];
+        simplex[0][i] = (p.initial - p.low) / (p.high - p.low);
+    }
+    for (int i = 0; i < d; i++) {
+        simplex[i + 1] = simplex[0];
+        simplex[i + 1][i] += simplex[0][i] <= 0.75 ? 0.25 : -0.25;
+    }
+    vector<vector<double>> samples = this->evaluate(simplex);
+    vector<double> initialSamples = samples[0];
+    vector<double> f(d + 1);
+    for (int i = 0; i <= d; i++) f[i] = mean(samples[i]);
+
+    int iterations = 0;
+    while (this->evaluated < this->evaluations) {
+        vector<int> order(d + 1);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](int a, int b) { return f[a] < f[b]; });
+        int best = order[0], worst = order[d], second = order[d - 1];
+
+        double size = 0;
+        for (int i = 0; i <= d; i++) {
+            for (int k = 0; k < d; k++) size = max(size, abs(simplex[i][k] - simplex[best][k]));
+        }
+        if (size < this->tolerance) break;
+        iterations++;
+
+        vector<double> centroid(d, 0);
+        for (int i = 0; i <= d; i++) {
+            if (i == worst) continue;
+            for (int k = 0; k < d; k++) centroid[k] += simplex[i][k] / d;
+        }
+        auto replace = [&](vector<double> x, vector<double> s) {
+            simplex[worst] = move(x);
+            f[worst] = mean(s);
+            samples[worst] = move(s);
+        };
+
+        vector<double> reflected = toward(centroid, simplex[worst], -1);
+        vector<double> fr = this->evaluate({ reflected })[0];
+        if (mean(fr) < f[best]) { // 擴張
+            vector<double> expanded = toward(centroid, simplex[worst], -2);
+            vector<double> fe = this->evaluate({ expanded })[0];
+            if (mean(fe) < mean(fr)) replace(expanded, fe);
+            else replace(reflected, fr);
+        } else if (mean(fr) < f[second]) { // 反射
+            replace(reflected, fr);
+        } else { // 收縮 (反射點較最差點好時向外，否則向內)
+            bool outside = mean(fr) < f[worst];
+            vector<double> contracted = toward(centroid, outside ? reflected : simplex[worst], 0.5);
+            vector<double> fc = this->evaluate({ contracted })[0];
+            if (mean(fc) < min(mean(fr), f[worst])) {
+                replace(contracted, fc);
+            } else { // 向最佳點縮小 (一批平行評估)
+                vector<vector<double>> shrunk;
+                for (int i = 0; i <= d; i++) if (i != best) shrunk.push_back(toward(simplex[best], simplex[i], 0.5));
+                vector<vector<double>> fs = this->evaluate(shrunk);
+                for (int i = 0, j = 0; i <= d; i++) {
+                    if (i == best) continue;
+                    simplex[i] = shrunk[j];
+                    samples[i] = fs[j++];
+                    f[i] = mean(samples[i]);
+                }
+            }
+        }
+    }
+    if (this->output.isOpen()) this->output.close();
+
+    /* 輸出最佳參數組與起始值的配對比較 */
+    int best = min_element(f.begin(), f.end()) - f.begin();
+    vector<double> bestValues = this->values(simplex[best]);
+    Welford diff;
+    for (int r = 0; r < this->runs; r++) diff.add(samples[best][r] - initialSamples[r]);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << ">>> Control parameter optimisation <<<\n";
+    cout << "Objective: " << Outcome::names[this->objective] << " (mean of " << this->runs << " runs per candidate, seeds "
+         << this->baseSeed << " .. " << this->baseSeed + this->runs - 1;
+    if (this->forkAt >= 0) cout << ", forked at " << this->forkAt << " s";
+    cout << ")\n" << fixed << setprecision(2) << "Evaluations: " << this->evaluated << " (" << iterations << " iterations) in " << seconds
+         << " s, " << this->evaluated * this->runs / seconds << " simulations/s\n";
+    cout << setprecision(4);
+    for (int i = 0; i < d; i++) {
+        const Parameter& p = this->parameters[i];
+        cout << "  " << left << setw(22) << p.key << right << " " << setw(10) << p.initial << " -> " << setw(10) << bestValues[i]
+             << "  [" << p.low << ", " << p.high << "]\n";
+    }
+    cout << "  " << left << setw(22) << Outcome::names[this->objective] << right << " " << setw(10) << mean(initialSamples)
+         << " -> " << setw(10) << f[best] << "  diff " << diff.mean << " +/- "
+         << (this->runs > 1 ? Experiment::tQuantile(this->runs - 1) * diff.sd() / sqrt(this->runs) : 0.0) << "\n";
+    cout << defaultfloat;
+}
@@ -14,7 +14,7 @@ void Plan::setPhase(string config) {
  * @param config signals.csv 的號誌時制設定字串
  */
     vector<string> segments;
-    regex pattern(R"(/[^/]+/[^/]+/[^/]+/[^/]+,[^/]+/)");  // 正則表達式匹配 /.../.../.../.../
+    static const regex pattern(R"(/[^/]+/[^/]+/[^/]+/[^/]+,[^/]+/)");  // 正則表達式匹配 /.../.../.../.../ (只編譯一次)
 
     /* 使用 sregex_iterator 遍歷配置字串，並根據正則表達式提取匹配的時相 */
     sregex_iterator it(config.begin(), config.end(), pattern); 
@@ -100,6 +100,22 @@ void Plan::processSegment(string segment) {
 
 }
 
+void Plan::scale(double factor) {
+/**
+ * @brief 將各時段的週期、時差及綠燈區間等比例縮放 (四捨五入至秒，綠燈區間至少 1 秒)，綠燈比不變
+ *
+ * @param factor 縮放倍率
+ */
+    for (size_t i = 0; i < this->cycle.size(); i++) {
+        this->cycle[i] = max(2, static_cast<int>(lround(this->cycle[i] * factor)));
+        this->offset[i] = static_cast<int>(lround(this->offset[i] * factor)) % this->cycle[i];
+        for (auto& [start, end] : this->phase[i]) {
+            start = lround(start * factor);
+            end = max(start + 1, static_cast<int>(lround(end * factor)));
+        }
+    }
+}
+
 int Plan::time2Seconds(const string& timeStr) {
 /**
  * @brief 將時間字串轉換為秒數
@@ -118,18 +134,20 @@ int Plan::time2Seconds(const string& timeStr) {
     return hours * 3600 + minutes * 60;
 }
 
-int Plan::calculateSignal(int timeStamp) {
+pair<int, int> Plan::locate(int timeStamp) {
 /**
- * @brief 計算當前時間戳 (timeStamp) 對應的號誌燈狀態
- * 
- * 此函式根據時間表 (`this->time`) 找出當前 `timeStamp` 所屬的時段，
- * 然後計算當前時間在該時段的週期內對應的時相 (phase)。
- * 若目標時間落在綠燈區間內，則返回 0，否則計算距離下一個綠燈的時間。
- * 
- * @param timeStamp 當前時間戳 (單位：秒)
- * @return int 若當前時相為綠燈，則回傳 0；否則回傳距離下一個綠燈的秒數
- * @throws std::runtime_error 若找不到對應的時相，則拋出錯誤
+ * @brief 找出時間戳所屬的時段，並計算在該時段週期內的相對時間
+ *
+ * 時間戳可超過一天 (多日模擬)，時段與週期皆以當日時間 (timeStamp mod 86400) 計算；
+ * 第一個時段之前的凌晨時間屬於前一天最後一個時段。
+ *
+ * @param timeStamp 時間戳 (單位：秒，可跨日)
+ * @return pair<int, int> { 時段索引, 週期內的相對時間 }
+ * @throws std::runtime_error 若找不到對應的時段
  */
+    int timeOfDay = timeStamp % 86400; // 當日時間
+    int dayTime = (timeOfDay < this->time[0]) ? timeOfDay + 86400 : timeOfDay; // 早於第一個時段時視為前一天的延續
+
     // 遍歷所有時段，使用 views::enumerate 取得索引與對應時間
     for (auto [index, value] : views::enumerate(this->time)) {
         // 計算下一個時段的索引，若已經是最後一個則回到 0 (表示跨日的時間表)
@@ -139,10 +157,8 @@ int Plan::calculateSignal(int timeStamp) {
         int nextTime = nextIndex ? this->time[nextIndex] : this->time[nextIndex] + 86400;
 
         // 判斷當前時間是否落在該時段內
-        if (timeStamp >= value && timeStamp <= nextTime) {
-            
-            
-            int startTime = timeStamp - this->offset[index]; // 計算相對於該時段的起始時間
+        if (dayTime >= value && dayTime < nextTime) {
+            int startTime = timeOfDay - this->offset[index]; // 計算相對於該時段的起始時間
             int cycleTime = this->cycle[index]; // 取得該時段的週期時間 (秒)
 
             /* 確保 `startTime` 為正數，若為負數則補足一個週期*/
@@ -151,29 +167,62 @@ int Plan::calculateSignal(int timeStamp) {
             }
 
             /* 計算當前時間在該時段的週期內對應的時間點 */
-            int target = startTime % cycleTime;
-
-            /* 遍歷該時段的時相區間，取得索引與 pair<int, int> */
-            for (auto&& t : views::enumerate(this->phase[index])) {
-                auto pairIndex = get<0>(t);  // 取得索引
-                auto& pairValue = get<1>(t); // 取得時相範圍 pair<int, int>
-
-                /* 若當前時間落在綠燈區間內，回傳 0 (表示為綠燈) */
-                if (target >= pairValue.first && target <= pairValue.second) {
-                    return 0;
-                } 
-                // 若為紅燈，計算距離下一次綠燈的秒數
-                else if (static_cast<size_t>(pairIndex) == this->phase[index].size() - 1) {
-                    int timeRemain = this->timeRemain(index, target);
-                    return timeRemain;
-                }
-            }
+            return { static_cast<int>(index), startTime % cycleTime };
         }
     }
 
     throw runtime_error("找不到對應的時相\n");
 }
 
+int Plan::calculateSignal(int timeStamp) {
+/**
+ * @brief 計算當前時間戳 (timeStamp) 對應的號誌燈狀態
+ * 
+ * 此函式根據時間表 (`this->time`) 找出當前 `timeStamp` 所屬的時段，
+ * 然後計算當前時間在該時段的週期內對應的時相 (phase)。
+ * 若目標時間落在綠燈區間內，則返回 0，否則計算距離下一個綠燈的時間。
+ * 
+ * @param timeStamp 當前時間戳 (單位：秒，可跨日)
+ * @return int 若當前時相為綠燈，則回傳 0；否則回傳距離下一個綠燈的秒數
+ * @throws std::runtime_error 若找不到對應的時相，則拋出錯誤
+ */
+    auto [index, target] = this->locate(timeStamp);
+
+    /* 遍歷該時段的時相區間，若當前時間落在綠燈區間內，回傳 0 (表示為綠燈) */
+    for (auto& range : this->phase[index]) {
+        if (target >= range.first && target <= range.second) return 0;
+    }
+
+    // 若為紅燈，計算距離下一次綠燈的秒數
+    return this->timeRemain(index, target);
+}
+
+GreenWindow Plan::greenWindow(int timeStamp) {
+/**
+ * @brief 取得 timeStamp 所在的綠燈時窗；紅燈時則為下一個綠燈時窗
+ *
+ * 紅燈開始為同一週期 (或前一週期) 中前一個綠燈區間的結束。
+ * 綠燈判定與 `calculateSignal` 相同，時段交界處的週期變化不另行處理。
+ *
+ * @param timeStamp 時間戳 (單位：秒，可跨日)
+ * @return GreenWindow 綠燈時窗 (絕對時間)
+ */
+    auto [index, target] = this->locate(timeStamp);
+    const auto& ranges = this->phase[index];
+    int cycleTime = this->cycle[index];
+    int n = ranges.size();
+
+    /* 目前所在或下一個綠燈區間 (next == n 表示下一週期的第一個區間) */
+    int next = 0;
+    while (next < n && target > ranges[next].second) next++;
+    int start = next < n ? ranges[next].first : ranges[0].first + cycleTime;
+    int end = next < n ? ranges[next].second : ranges[0].second + cycleTime;
+    int prevEnd = next > 0 ? ranges[next - 1].second : ranges[n - 1].second - cycleTime;
+
+    int base = timeStamp - target; // 本週期起點的絕對時間
+    return { base + prevEnd, base + start, base + end };
+}
+
 int Plan::timeRemain(int index, int target) {
 /**
  * @brief 計算距離下一個綠燈開始的剩餘時間
@@ -0,0 +1,97 @@
+#include "Profiler.hpp"
+#include "Writer.hpp"
+
+double Profiler::nanosPerTick() {
+/**
+ * @brief 計時器刻度與奈秒的換算比例
+ *
+ * 使用 rdtsc 時，以 steady_clock 量測約 10 毫秒內的刻度數校正一次 (整個行程共用)；
+ * 非 x86 平台直接使用 steady_clock，刻度即為奈秒。
+ */
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ratio = [] {
+        auto begin = chrono::steady_clock::now();
+        uint64_t start = now();
+        while (chrono::steady_clock::now() - begin < chrono::milliseconds(10)) {}
+        uint64_t end = now();
+        double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+        return elapsed / max<uint64_t>(1, end - start);
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+const char* Profiler::name(Section section) {
+    const char* names[] = { "", "arriveAtStop", "deptFromStop", "arriveAtLight", "deptFromLight", "accrueDemand", "enterBerth",
+                            "findStop", "findSignal", "findNext", "findNextStop", "findPrevBus", "predictiveControl" };
+    return names[static_cast<size_t>(section)];
+}
+
+void Profiler::setTracing(bool enabled) {
+    this->tracing = enabled;
+    if (!enabled) trace.clear();
+}
+
+void Profiler::merge(const Profiler& other) {
+/**
+ * @brief 合併另一份剖析結果 (次數與耗時累加，高水位取較大者；trace 記錄不合併)
+ *
+ * @param other 另一次模擬的剖析結果
+ */
+    for (size_t i = 0; i < stats.size(); i++) {
+        stats[i].count += other.stats[i].count;
+        stats[i].ticks += other.stats[i].ticks;
+    }
+    queueHighWater = max(queueHighWater, other.queueHighWater);
+}
+
+void Profiler::report(ostream& os) const {
+/**
+ * @brief 輸出剖析表: 各區段的次數、總耗時、平均耗時與佔事件處理總耗時的比例
+ *
+ * 查找與排序區段皆在事件處理區段之內執行，因此其耗時同時計入所屬事件處理區段。
+ */
+    double handlerNanos = 0;
+    for (int s = static_cast<int>(Section::ArriveStop); s <= static_cast<int>(Section::EnterBerth); s++) {
+        handlerNanos += this->nanos(static_cast<Section>(s));
+    }
+
+    os << ">>> Profile <<<\n" << setfill(' ');
+    os << left << setw(16) << "section" << right << setw(12) << "count" << setw(12) << "total ms"
+       << setw(12) << "ns/call" << setw(10) << "share" << "\n";
+    for (int s = 1; s < static_cast<int>(Section::Count); s++) {
+        Section section = static_cast<Section>(s);
+        if (!this->count(section)) continue;
+        double total = this->nanos(section);
+        os << left << setw(16) << name(section) << right << setw(12) << this->count(section)
+           << setw(12) << fixed << setprecision(2) << total / 1e6
+           << setw(12) << setprecision(0) << total / this->count(section)
+           << setw(9) << setprecision(1) << (handlerNanos > 0 ? total / handlerNanos * 100 : 0.0) << "%\n";
+    }
+    os << defaultfloat << setprecision(6);
+    os << "Event list high-water mark: " << queueHighWater << "\n";
+}
+
+void Profiler::writeTrace(const string& path) const {
+/**
+ * @brief 將事件處理區段輸出為 Chrome trace JSON ("X" complete events，時間單位為微秒)
+ *
+ * @param path 輸出檔案路徑
+ */
+    BufferedWriter writer;
+    writer.open(path);
+    double scale = nanosPerTick() / 1000;
+    uint64_t origin = trace.empty() ? 0 : trace.front().start;
+
+    writer << "{\"traceEvents\":[";
+    for (size_t i = 0; i < trace.size(); i++) {
+        const TraceEvent& e = trace[i];
+        if (i) writer << ',';
+        writer << "{\"name\":\"" << name(e.section) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"
+               << (e.start - origin) * scale << ",\"dur\":" << e.duration * scale << '}';
+    }
+    writer << "],\"displayTimeUnit\":\"ns\"}\n";
+    writer.close();
+}
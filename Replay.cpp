@@ -0,0 +1,217 @@
+#include "Replay.hpp"
+#include "Gtfs.hpp"
+
+Replay::Replay(System& system, const toml::table& config) {
+/**
+ * @brief 讀取 [replay] 設定: file (AVL 檔案，相對於 general.dataDir 或絕對路徑)、radius (站點範圍半徑，預設 30 公尺)、
+ *        timeout (車輛無定位多久後視為結束營運，預設 1800 秒)、output (逐次離站的建議與實際值 CSV)
+ *
+ * @param system 已初始化的系統 (站點里程、控制參數)
+ * @param config 設定
+ * @throws runtime_error 若 radius 或 timeout 不為正值
+ */
+    string dataDir = config["general"]["dataDir"].value_or("./data");
+    this->path = (filesystem::path(dataDir) / config["replay"]["file"].value_or("")).string();
+    this->outputPath = config["replay"]["output"].value_or("");
+    this->radius = config["replay"]["radius"].value_or(30.0);
+    this->timeout = config["replay"]["timeout"].value_or(1800);
+    if (this->radius <= 0) throw runtime_error("錯誤: 'replay.radius' 必須大於 0");
+    if (this->timeout <= 0) throw runtime_error("錯誤: 'replay.timeout' 必須大於 0");
+
+    this->stops = system.getStopMileages();
+    this->advisor = system.getAdvisor();
+    this->Vavg = system.getAvgSpeed();
+    this->Tmax = system.getTmax();
+    this->scheduledHeadway = system.getScheduledHeadway();
+    this->dwell.assign(this->stops.size(), Welford());
+    this->lastArrival.assign(this->stops.size(), -1);
+}
+
+static bool parseNumber(string_view text, double& value) {
+    auto [ptr, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return ec == errc() && ptr == text.data() + text.size();
+}
+
+void Replay::run() {
+/**
+ * @brief 逐列重播 AVL 檔案
+ *
+ * 時間欄位可為秒數 (例如 Unix time) 或 "HH:MM:SS"。各車的定位須依時間排序 (不同車輛可交錯)，
+ * 時間倒退的定位略過不計；里程倒退 (定位誤差) 視為停在原地。
+ * 車輛駛離終點站範圍或超過 timeout 沒有定位時即釋放其狀態。
+ *
+ * @throws runtime_error 若檔案無法開啟、缺少必要欄位或數值格式錯誤
+ */
+    CsvStream csv(this->path);
+    int busCol = csv.column("bus"), timeCol = csv.column("time"), mileageCol = csv.column("mileage");
+    if (busCol < 0 || timeCol < 0) throw runtime_error(this->path + " 缺少 bus 或 time 欄位");
+    if (mileageCol < 0) throw runtime_error(this->path + " 缺少 mileage 欄位 (依經緯度定位需要路線幾何，目前不支援)");
+
+    if (!this->outputPath.empty()) {
+        this->output.open(this->outputPath);
+        this->output << "bus,stop,time,distance,bunching,adviceKph,actualKph,adviceDwell,actualDwell\n";
+    }
+
+    auto start = chrono::steady_clock::now();
+    int nextSweep = INT_MIN;
+    while (csv.next()) {
+        this->rows++;
+        string_view id = csv.field(busCol), timeText = csv.field(timeCol);
+        double time, mileage;
+        if (timeText.find(':') != string_view::npos) time = Gtfs::parseTime(timeText);
+        else if (!parseNumber(timeText, time)) time = -1;
+        if (time < 0 || !parseNumber(csv.field(mileageCol), mileage)) {
+            throw runtime_error(this->path + " 第 " + to_string(this->rows + 1) + " 列: 時間或里程格式錯誤");
+        }
+        int t = static_cast<int>(time);
+        this->firstTime = min(this->firstTime, t);
+        this->lastTime = max(this->lastTime, t);
+
+        auto it = this->tracks.find(id);
+        if (it == this->tracks.end()) { // 新的車輛: 略過已經過的站點
+            int next = lower_bound(this->stops.begin(), this->stops.end(), mileage - this->radius) - this->stops.begin();
+            if (next >= static_cast<int>(this->stops.size())) continue;
+            Track& track = this->tracks.try_emplace(string(id)).first->second;
+            track.time = t;
+            track.mileage = mileage;
+            track.next = next;
+            track.headway = this->scheduledHeadway;
+            if (mileage >= this->stops[next] - this->radius) track.arrive = t;
+            this->buses++;
+            this->peakTracks = max(this->peakTracks, this->tracks.size());
+            continue;
+        }
+        if (t < it->second.time) {
+            this->skipped++;
+            continue;
+        }
+        this->update(it->first, it->second, t, mileage);
+        if (it->second.next >= static_cast<int>(this->stops.size())) this->tracks.erase(it);  // 駛離終點站
+
+        if (t >= nextSweep) {
+            this->sweep(t);
+            nextSweep = t + this->timeout;
+        }
+    }
+    this->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (this->output.isOpen()) this->output.close();
+}
+
+void Replay::report() const {
+    cout << ">>> AVL replay <<<\n";
+    cout << "Rows: " << this->rows << " (" << this->skipped << " out of order), buses: " << this->buses
+         << ", peak active: " << this->peakTracks << "\n";
+    if (this->rows > 0) {
+        double span = max(0, this->lastTime - this->firstTime), elapsed = max(this->seconds, 1e-9);
+        cout << fixed << setprecision(1) << "Replayed " << span / 3600 << " h in " << setprecision(3) << this->seconds << " s ("
+             << setprecision(0) << this->rows / elapsed << " rows/s, " << span / elapsed << "x real time)\n";
+    }
+    cout << setprecision(2) << "Departures evaluated: " << this->departures << ", flagged as bunching: " << this->bunched;
+    if (this->departures > 0) cout << " (" << 100.0 * this->bunched / this->departures << "%)";
+    cout << "\nActual headway: mean " << this->headway.mean << " s, cv " << this->headway.cv()
+         << ", mean |headway - dispatch headway| " << this->headwayDev.mean << " s\n";
+    cout << "Advice - actual: speed " << this->speedGap.mean << " +/- " << this->speedGap.sd() << " kph, dwell "
+         << this->dwellGap.mean << " +/- " << this->dwellGap.sd() << " s (" << this->speedGap.n << " links)\n";
+    cout << defaultfloat;
+}
+
+int Replay::cross(const Track& track, int time, double mileage, double at) const {
+/**
+ * @brief 以前後兩筆定位線性內插經過里程 at 的時間
+ */
+    if (mileage <= track.mileage || at <= track.mileage) return track.time;
+    double ratio = min(1.0, (at - track.mileage) / (mileage - track.mileage));
+    return track.time + static_cast<int>(lround((time - track.time) * ratio));
+}
+
+void Replay::update(string_view id, Track& track, int time, double mileage) {
+/**
+ * @brief 依新的定位推進車輛: 依序處理進入與離開的站點範圍 (兩筆定位之間可經過多個站點)
+ *
+ * @param id 車輛編號
+ * @param track 車輛狀態
+ * @param time 定位時間 (秒)
+ * @param mileage 定位里程 (公尺)
+ */
+    mileage = max(mileage, track.mileage);  // 對應至路線里程順序，不允許倒退
+    while (track.next < static_cast<int>(this->stops.size())) {
+        double at = this->stops[track.next];
+        if (track.arrive < 0) {
+            if (mileage < at - this->radius) break;
+            this->arrive(track, track.next, this->cross(track, time, mileage, at - this->radius));
+        }
+        if (mileage <= at + this->radius) break;
+        this->depart(id, track, track.next, this->cross(track, time, mileage, at + this->radius));
+        track.arrive = -1;
+        track.next++;
+    }
+    track.time = time;
+    track.mileage = mileage;
+}
+
+void Replay::arrive(Track& track, int stop, int time) {
+    track.arrive = time;
+    if (this->lastArrival[stop] >= 0) {
+        int h = time - this->lastArrival[stop];
+        this->headway.add(h);
+        this->headwayDev.add(abs(h - track.headway));
+    }
+    this->lastArrival[stop] = time;
+}
+
+void Replay::depart(string_view id, Track& track, int stop, int time) {
+/**
+ * @brief 車輛離開站點範圍: 比較上一站的建議與實際值，並以其他車輛目前的實際位置評估本站的建議
+ *
+ * 前車為目前位置在本站之後最近的車輛；下一站的置站時間以該站至今的平均實際置站時間預估。
+ *
+ * @param id 車輛編號
+ * @param track 車輛狀態
+ * @param stop 站點編號
+ * @param time 離站時間 (秒)
+ */
+    int dwellTime = time - track.arrive;
+    this->dwell[stop].add(dwellTime);
+    if (stop == 0) {
+        track.headway = this->lastDispatch >= 0 ? time - this->lastDispatch : this->scheduledHeadway;
+        this->lastDispatch = time;
+    }
+
+    /* 上一站的建議與實際路段速度、本站置站時間比較 */
+    if (stop > 0 && track.adviceStop == stop - 1) {
+        double link = (this->stops[stop] - this->radius) - (this->stops[stop - 1] + this->radius);
+        double actual = link > 0 ? link / max(1, track.arrive - track.adviceTime) : track.adviceVol;
+        this->speedGap.add((track.adviceVol - actual) * 3.6);
+        this->dwellGap.add(track.adviceDwell - dwellTime);
+        if (this->output.isOpen()) {
+            this->output << string(id) << ',' << track.adviceStop << ',' << track.adviceTime << ',' << track.distance << ','
+                         << (track.bunching ? 1 : 0) << ',' << track.adviceVol * 3.6 << ',' << actual * 3.6 << ','
+                         << track.adviceDwell << ',' << dwellTime << '\n';
+        }
+    }
+    track.adviceStop = -1;
+    if (stop + 1 >= static_cast<int>(this->stops.size())) return;  // 終點站
+
+    /* 評估控制策略 (影子模式) */
+    const Track* leader = nullptr;
+    for (auto& [other, state] : this->tracks) {
+        if (&state != &track && state.mileage > this->stops[stop] && (!leader || state.mileage < leader->mileage)) leader = &state;
+    }
+    optional<double> distance;
+    if (leader) distance = leader->mileage - this->stops[stop];
+    int expected = this->dwell[stop + 1].n ? static_cast<int>(this->dwell[stop + 1].mean) : 0;
+    Advice advice = this->advisor.advise(this->Vavg, track.headway, expected, distance);
+
+    this->departures++;
+    this->bunched += advice.bunching;
+    track.adviceStop = stop;
+    track.adviceTime = time;
+    track.adviceVol = advice.vol;
+    track.adviceDwell = min(this->Tmax, advice.dwell);
+    track.bunching = advice.bunching;
+    track.distance = distance.value_or(-1);
+}
+
+void Replay::sweep(int now) {
+    erase_if(this->tracks, [&](const auto& entry) { return entry.second.time < now - this->timeout; });
+}
@@ -0,0 +1,217 @@
+#include "Replication.hpp"
+#include "Metrics.hpp"
+
+Replication::Replication(const string& configPath) {
+/**
+ * @brief 讀取設定檔中的自適應重複實驗設定
+ *
+ * [replication] 區段: halfWidth (95% 信賴區間半寬的目標)、relative (halfWidth 為相對於估計值絕對值的比例)、metric (Outcome 的欄位名稱，預設 headwayDeviation)、
+ * minRuns / maxRuns (模擬次數的下限與上限，對偶抽樣時每個單位為兩次)、threads、antithetic、controlVariates、
+ * output (逐個單位的結果 CSV)。
+ *
+ * @param configPath 設定檔路徑
+ * @throws runtime_error 若目標值不存在，或使用控制變數但班表不是由 schedule.avg / schedule.sd 抽樣
+ */
+    this->config = toml::parse_file(configPath);
+    this->target = this->config["replication"]["halfWidth"].value_or(0.0);
+    this->relative = this->config["replication"]["relative"].value_or(false);
+    this->minRuns = max(3, this->config["replication"]["minRuns"].value_or(10));
+    this->maxRuns = max(this->minRuns, this->config["replication"]["maxRuns"].value_or(1000));
+    this->threads = max(1, this->config["replication"]["threads"].value_or(1));
+    this->antithetic = this->config["replication"]["antithetic"].value_or(false);
+    this->controlVariates = this->config["replication"]["controlVariates"].value_or(false);
+    this->outputPath = this->config["replication"]["output"].value_or("");
+    auto seed = this->config["general"]["seed"].value<int64_t>();
+    this->baseSeed = seed ? static_cast<uint64_t>(*seed) : random_device{}();
+
+    string metricName = this->config["replication"]["metric"].value_or("headwayDeviation");
+    auto name = find(Outcome::names.begin(), Outcome::names.end(), metricName);
+    if (name == Outcome::names.end()) throw runtime_error("錯誤: 'replication.metric' 必須為 Outcome 的欄位 (例如 headwayDeviation)");
+    this->metric = name - Outcome::names.begin();
+
+    if (this->controlVariates) {
+        auto avg = this->config["schedule"]["avg"].value<double>(), sd = this->config["schedule"]["sd"].value<double>();
+        if (!avg || !sd || !string(this->config["schedule"]["file"].value_or("")).empty()
+            || !string(this->config["schedule"]["gtfs"].value_or("")).empty()) {
+            throw runtime_error("錯誤: 'replication.controlVariates' 需要由 schedule.avg / schedule.sd 抽樣的班表");
+        }
+        this->expected = { *avg * 60, (*sd * 60) * (*sd * 60) };
+    }
+
+    if (!this->config.contains("general")) this->config.insert("general", toml::table{});
+    this->config["general"].as_table()->insert_or_assign("antithetic", false);
+    this->mirrored = this->config;
+    this->mirrored["general"].as_table()->insert_or_assign("antithetic", true);
+}
+
+Replicate Replication::simulate(int unit) const {
+/**
+ * @brief 以種子 baseSeed + unit 模擬一次 (對偶抽樣時再以同一種子的鏡射抽樣模擬一次)，並計算控制變數
+ *
+ * @param unit 單位編號
+ * @return Replicate 目標值 (對偶抽樣時為兩次的平均) 與控制變數
+ */
+    Replicate result{};
+    int count = this->antithetic ? 2 : 1;
+    for (int k = 0; k < count; k++) {
+        auto system = Experiment::prepare(k ? this->mirrored : this->config, this->baseSeed + unit, -1);
+        system->simulation();
+        result.runs[k] = Outcome::of(*system).values[this->metric];
+        result.value += result.runs[k] / count;
+        if (!this->controlVariates) continue; // 班表非抽樣產生時沒有抽樣值
+
+        const vector<double>& draws = system->getScheduleDraws();
+        double mean = 0, spread = 0;
+        for (double h : draws) {
+            mean += h;
+            spread += (h - this->expected[0]) * (h - this->expected[0]);
+        }
+        result.control[0] += mean / draws.size() / count;
+        result.control[1] += spread / draws.size() / count;
+    }
+    return result;
+}
+
+Estimate Replication::estimate(const vector<Replicate>& units, bool useControls) const {
+/**
+ * @brief 樣本平均與 95% 信賴區間；使用控制變數時以最小平方法估計迴歸係數 beta，
+ *        估計值為 mean(Y) - beta * (mean(C) - E[C])，變異數為迴歸殘差的變異數
+ *
+ * 兩個控制變數幾乎共線 (例如對偶抽樣下抽樣值的平均) 或變異數為 0 時只使用其中可用者。
+ *
+ * @param units 已完成的單位
+ * @param useControls 是否使用控制變數
+ * @return Estimate 估計值、信賴區間半寬、單位的 (殘差) 變異數與使用的控制變數數
+ */
+    constexpr int q = Replicate::controls;
+    int n = units.size();
+    double y = 0;
+    array<double, q> c{};
+    for (auto& u : units) {
+        y += u.value / n;
+        for (int k = 0; k < q; k++) c[k] += u.control[k] / n;
+    }
+
+    /* 共變異數矩陣 S 與 Cov(C, Y) */
+    array<array<double, q>, q> S{};
+    array<double, q> s{};
+    for (auto& u : units) {
+        for (int k = 0; k < q; k++) {
+            s[k] += (u.control[k] - c[k]) * (u.value - y);
+            for (int l = 0; l < q; l++) S[k][l] += (u.control[k] - c[k]) * (u.control[l] - c[l]);
+        }
+    }
+
+    /* 依序消去解 S * beta = Cov(C, Y)，與已選入的控制變數共線者不使用 */
+    array<double, q> beta{};
+    array<bool, q> active{};
+    int p = 0;
+    if (useControls) {
+        array<array<double, q>, q> A = S;
+        array<double, q> b = s;
+        for (int k = 0; k < q; k++) {
+            if (A[k][k] <= 1e-9 * S[k][k] || S[k][k] <= 0) continue;
+            active[k] = true;
+            p++;
+            for (int l = k + 1; l < q; l++) {
+                double f = A[l][k] / A[k][k];
+                for (int m = k; m < q; m++) A[l][m] -= f * A[k][m];
+                b[l] -= f * b[k];
+            }
+        }
+        for (int k = q - 1; k >= 0; k--) {
+            if (!active[k]) continue;
+            double r = b[k];
+            for (int l = k + 1; l < q; l++) r -= A[k][l] * beta[l];
+            beta[k] = r / A[k][k];
+        }
+    }
+
+    Estimate result{ y, numeric_limits<double>::infinity(), 0, p };
+    for (int k = 0; k < q; k++) result.mean -= beta[k] * (c[k] - this->expected[k]);
+    if (n < p + 2) return result;
+    for (auto& u : units) {
+        double e = u.value - y;
+        for (int k = 0; k < q; k++) e -= beta[k] * (u.control[k] - c[k]);
+        result.variance += e * e;
+    }
+    result.variance /= n - 1 - p;
+    result.halfWidth = Experiment::tQuantile(n - 1 - p) * sqrt(result.variance / n);
+    return result;
+}
+
+void Replication::run() {
+/**
+ * @brief 平行模擬各單位，依單位編號的順序逐一納入，信賴區間半寬低於目標時停止
+ *
+ * 各執行緒依序領取下一個單位；單位完成後若其前面的單位皆已完成即依序納入並檢查停止條件，
+ * 停止時正在模擬中的單位 (最多 threads - 1 個) 不納入，因此結果與執行緒數無關。
+ * 輸出估計值以及相對於獨立重複實驗的變異數縮減倍數。
+ */
+    auto start = chrono::steady_clock::now();
+    int count = this->antithetic ? 2 : 1;
+    int minUnits = max(3, (this->minRuns + count - 1) / count), maxUnits = max(minUnits, this->maxRuns / count);
+
+    vector<optional<Replicate>> results(maxUnits);
+    vector<Replicate> units;
+    atomic<int> started = 0; // 已開始模擬的單位數
+    bool done = false, reached = false;
+    mutex lock;
+    Experiment::parallelFor(this->threads, maxUnits, [&](long long u, int) {
+        started++;
+        Replicate result = this->simulate(u);
+        lock_guard<mutex> guard(lock);
+        results[u] = result;
+        while (!done && units.size() < results.size() && results[units.size()]) {
+            units.push_back(*results[units.size()]);
+            if (static_cast<int>(units.size()) >= minUnits) {
+                Estimate current = this->estimate(units, this->controlVariates);
+                if (current.halfWidth <= this->target * (this->relative ? abs(current.mean) : 1)) done = reached = true;
+            }
+        }
+        if (static_cast<int>(units.size()) == maxUnits) done = true;
+        return !done;
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int n = units.size();
+    if (!this->outputPath.empty()) {
+        BufferedWriter file;
+        file.open(this->outputPath);
+        file << "unit,seed," << Outcome::names[this->metric] << ",normal,antithetic,drawMean,drawSpread\n";
+        for (int u = 0; u < n; u++) {
+            file << u << "," << static_cast<long long>(this->baseSeed + u) << "," << units[u].value << "," << units[u].runs[0] << ",";
+            if (this->antithetic) file << units[u].runs[1];
+            file << "," << units[u].control[0] << "," << units[u].control[1] << "\n";
+        }
+        file.close();
+    }
+
+    /* 與獨立重複實驗比較 (每次模擬各自為一個樣本) */
+    Welford single;
+    for (auto& u : units) {
+        for (int k = 0; k < count; k++) single.add(u.runs[k]);
+    }
+    Estimate plain = this->estimate(units, false);
+    Estimate adjusted = this->controlVariates ? this->estimate(units, true) : plain;
+    int simulations = n * count;
+    double independent = Experiment::tQuantile(simulations - 1) * single.sd() / sqrt(simulations);
+
+    cout << ">>> Adaptive replication <<<\n";
+    cout << "Metric: " << Outcome::names[this->metric] << ", target " << (this->relative ? "relative " : "") << "half-width " << this->target << " (95%)";
+    if (this->antithetic) cout << ", antithetic pairs";
+    if (this->controlVariates) cout << ", " << adjusted.controls << " control variate(s)";
+    cout << "\n" << fixed << setprecision(2) << "Runs: " << simulations << " (seeds " << this->baseSeed << " .. "
+         << this->baseSeed + n - 1 << "), " << (reached ? "target reached" : "stopped at maxRuns") << " in " << seconds
+         << " s, " << started.load() * count / max(seconds, 1e-9) << " simulations/s\n";
+    cout << setprecision(6) << "Estimate: " << adjusted.mean << " +/- " << adjusted.halfWidth << "\n";
+    if (this->controlVariates) cout << "  without control variates  " << plain.mean << " +/- " << plain.halfWidth << "\n";
+    cout << "  independent runs          " << single.mean << " +/- " << independent << "\n";
+    cout << setprecision(2) << "Variance reduction:";
+    if (this->antithetic) cout << " antithetic x" << (plain.variance > 0 ? single.variance() / 2 / plain.variance : 0.0);
+    if (this->controlVariates) cout << " control variates x" << (adjusted.variance > 0 ? plain.variance / adjusted.variance : 0.0);
+    if (adjusted.variance > 0) {
+        cout << " (equivalent to " << setprecision(0) << single.variance() * n / adjusted.variance << " independent runs)";
+    }
+    cout << "\n" << defaultfloat;
+}
@@ -0,0 +1,267 @@
+#include "Sensitivity.hpp"
+#include "Metrics.hpp"
+
+/* Joe-Kuo (new-joe-kuo-6.21201) 第 2 .. 20 維的本原多項式: { 次數 s, 係數 a, 起始方向數 m_1 .. m_s } */
+struct SobolPrimitive {
+    int s;
+    uint32_t a;
+    array<uint32_t, 7> m;
+};
+static constexpr array<SobolPrimitive, SobolSequence::maxDimensions - 1> sobolPrimitives = { {
+    { 1, 0, { 1 } }, { 2, 1, { 1, 3 } }, { 3, 1, { 1, 3, 1 } }, { 3, 2, { 1, 1, 1 } },
+    { 4, 1, { 1, 1, 3, 3 } }, { 4, 4, { 1, 3, 5, 13 } }, { 5, 2, { 1, 1, 5, 5, 17 } }, { 5, 4, { 1, 1, 5, 5, 5 } },
+    { 5, 7, { 1, 1, 7, 11, 19 } }, { 5, 11, { 1, 1, 5, 1, 1 } }, { 5, 13, { 1, 1, 1, 3, 11 } }, { 5, 14, { 1, 3, 5, 5, 31 } },
+    { 6, 1, { 1, 3, 3, 9, 7, 49 } }, { 6, 13, { 1, 1, 1, 15, 21, 21 } }, { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+    { 6, 19, { 1, 1, 1, 15, 7, 5 } }, { 6, 22, { 1, 3, 1, 15, 13, 25 } }, { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+    { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+} };
+
+SobolSequence::SobolSequence(int dimensions) {
+/**
+ * @brief 計算各維的方向數 V_1 .. V_32 (以 32 位元定點數表示)
+ *
+ * 第一維為 van der Corput 序列；其餘各維 V_i = m_i / 2^i (i <= s)，之後依本原多項式遞迴:
+ * V_i = V_{i-s} ^ (V_{i-s} >> s) ^ (a_1 V_{i-1}) ^ ... ^ (a_{s-1} V_{i-s+1})。
+ *
+ * @param dimensions 維度
+ * @throws runtime_error 若維度超過 maxDimensions
+ */
+    if (dimensions < 1 || dimensions > maxDimensions) {
+        throw runtime_error("錯誤: Sobol 序列的維度必須介於 1 到 " + to_string(maxDimensions) + " 之間");
+    }
+    this->direction.resize(dimensions);
+    for (int i = 0; i < 32; i++) this->direction[0][i] = 1u << (31 - i);
+    for (int d = 1; d < dimensions; d++) {
+        const SobolPrimitive& p = sobolPrimitives[d - 1];
+        auto& v = this->direction[d];
+        for (int i = 0; i < 32; i++) {
+            if (i < p.s) {
+                v[i] = p.m[i] << (31 - i);
+                continue;
+            }
+            v[i] = v[i - p.s] ^ (v[i - p.s] >> p.s);
+            for (int k = 1; k < p.s; k++) {
+                if ((p.a >> (p.s - 1 - k)) & 1) v[i] ^= v[i - k];
+            }
+        }
+    }
+}
+
+vector<double> SobolSequence::point(uint32_t n) const {
+/**
+ * @brief 第 n 點: 各維為 n 的格雷碼 (n ^ (n >> 1)) 中為 1 的位元所對應方向數的 XOR
+ *
+ * @param n 點的編號 (第 0 點為原點)
+ * @return vector<double> 各維座標
+ */
+    uint32_t gray = n ^ (n >> 1);
+    vector<double> x(this->direction.size());
+    for (size_t d = 0; d < this->direction.size(); d++) {
+        uint32_t bits = 0;
+        for (int i = 0; i < 32 && gray >> i; i++) {
+            if ((gray >> i) & 1) bits ^= this->direction[d][i];
+        }
+        x[d] = bits / 4294967296.0;
+    }
+    return x;
+}
+
+Sensitivity::Sensitivity(const string& configPath) {
+/**
+ * @brief 讀取設定檔中的敏感度分析設定
+ *
+ * [sensitivity] 區段: samples (基礎樣本數 N，建議為 2 的次方)、threads、bootstrap (信賴區間的重抽次數，預設 200)、
+ * output (逐次模擬結果 CSV)，以及 [sensitivity.parameters] 中各參數的範圍，例如 schedule = { sd = [0.5, 2.0] }；
+ * 參數須為設定檔中已有的數值欄位。
+ *
+ * @param configPath 設定檔路徑
+ * @throws runtime_error 若參數少於一個或超過 10 個、範圍格式錯誤或欄位不存在
+ */
+    this->config = toml::parse_file(configPath);
+    this->samples = max(2, this->config["sensitivity"]["samples"].value_or(1024));
+    this->threads = max(1, this->config["sensitivity"]["threads"].value_or(1));
+    this->bootstrap = max(0, this->config["sensitivity"]["bootstrap"].value_or(200));
+    this->outputPath = this->config["sensitivity"]["output"].value_or("");
+    auto seed = this->config["general"]["seed"].value<int64_t>();
+    this->baseSeed = seed ? static_cast<uint64_t>(*seed) : random_device{}();
+
+    if (auto table = this->config["sensitivity"]["parameters"].as_table()) {
+        for (auto& [section, keys] : *table) {
+            if (!keys.is_table()) throw runtime_error("錯誤: 'sensitivity.parameters." + string(section.str()) + "' 必須為表格");
+            for (auto& [key, range] : *keys.as_table()) {
+                Parameter parameter;
+                parameter.key = string(section.str()) + "." + string(key.str());
+                auto* bounds = range.as_array();
+                if (!bounds || bounds->size() != 2 || !(*bounds)[0].value<double>() || !(*bounds)[1].value<double>()) {
+                    throw runtime_error("錯誤: 參數 '" + parameter.key + "' 的範圍必須為 [下限, 上限]");
+                }
+                parameter.low = *(*bounds)[0].value<double>();
+                parameter.high = *(*bounds)[1].value<double>();
+                if (parameter.low >= parameter.high) throw runtime_error("錯誤: 參數 '" + parameter.key + "' 的下限必須小於上限");
+                auto node = this->config[section.str()][key.str()];
+                if (!node.is_number()) throw runtime_error("錯誤: 參數 '" + parameter.key + "' 必須為設定檔中的數值欄位");
+                parameter.initial = *node.value<double>();
+                this->integer.push_back(node.is_integer());
+                this->parameters.push_back(parameter);
+            }
+        }
+    }
+    if (this->parameters.empty()) throw runtime_error("錯誤: 敏感度分析至少需要一個 [sensitivity.parameters] 參數");
+    if (2 * this->parameters.size() > SobolSequence::maxDimensions) {
+        throw runtime_error("錯誤: 敏感度分析最多 " + to_string(SobolSequence::maxDimensions / 2) + " 個參數");
+    }
+}
+
+vector<SobolIndex> Sensitivity::indices(const vector<Outcome>& results, int metric) const {
+/**
+ * @brief 計算一個目標值的各參數 Sobol 指標
+ *
+ * 以 f(A)、f(B) 的 2N 個值估計總變異數 V，
+ * S_i = mean(f(B) (f(AB_i) - f(A))) / V (Saltelli 2010)，ST_i = mean((f(A) - f(AB_i))^2) / 2V (Jansen)。
+ * 信賴區間: 對列 (基礎樣本) 重抽 bootstrap 次，以 1.96 倍標準差為半寬。
+ *
+ * @param results 各次模擬的績效 (第 j 列第 c 欄位於 j * (d + 2) + c；欄 0 為 A、1 為 B、2 + i 為 AB_i)
+ * @param metric 目標值 (Outcome 的索引)
+ * @return vector<SobolIndex> 各參數的指標
+ */
+    int d = this->parameters.size(), columns = d + 2;
+    auto f = [&](int row, int column) { return results[static_cast<size_t>(row) * columns + column].values[metric]; };
+    auto estimate = [&](const vector<int>& rows, vector<double>& first, vector<double>& total) {
+        Welford all;
+        for (int j : rows) {
+            all.add(f(j, 0));
+            all.add(f(j, 1));
+        }
+        double variance = all.variance();
+        for (int i = 0; i < d; i++) {
+            double s = 0, st = 0;
+            for (int j : rows) {
+                double a = f(j, 0), ab = f(j, 2 + i);
+                s += f(j, 1) * (ab - a);
+                st += (a - ab) * (a - ab);
+            }
+            first[i] = variance > 0 ? s / rows.size() / variance : 0;
+            total[i] = variance > 0 ? st / rows.size() / 2 / variance : 0;
+        }
+    };
+
+    vector<int> rows(this->samples);
+    iota(rows.begin(), rows.end(), 0);
+    vector<double> first(d), total(d);
+    estimate(rows, first, total);
+
+    vector<Welford> firstSpread(d), totalSpread(d);
+    mt19937 gen(this->baseSeed);
+    uniform_int_distribution<int> pick(0, this->samples - 1);
+    vector<int> resampled(this->samples);
+    vector<double> s(d), st(d);
+    for (int b = 0; b < this->bootstrap; b++) {
+        for (int& j : resampled) j = pick(gen);
+        estimate(resampled, s, st);
+        for (int i = 0; i < d; i++) {
+            firstSpread[i].add(s[i]);
+            totalSpread[i].add(st[i]);
+        }
+    }
+
+    vector<SobolIndex> result(d);
+    for (int i = 0; i < d; i++) result[i] = { first[i], 1.96 * firstSpread[i].sd(), total[i], 1.96 * totalSpread[i].sd() };
+    return result;
+}
+
+void Sensitivity::analyze() {
+/**
+ * @brief 產生 Saltelli 樣本並平行執行 N x (d + 2) 次模擬，輸出各目標值的一階與總效應指標
+ *
+ * Sobol 序列跳過第 0 點 (原點)，第 j 列取第 j + 1 點: 前 d 維為 A、後 d 維為 B，再依範圍轉換為參數值。
+ * 各執行緒只複製一次設定 (關閉所有輸出)，每次模擬前覆寫種子與參數後直接初始化，
+ * 工作依序號分配給各執行緒 (`Experiment::parallelFor`)，結果依序號存放，輸出與執行緒數無關。
+ */
+    auto start = chrono::steady_clock::now();
+    int d = this->parameters.size(), columns = d + 2;
+    long long runs = static_cast<long long>(this->samples) * columns;
+
+    /* Saltelli 樣本: A 與 B */
+    SobolSequence sequence(2 * d);
+    vector<vector<double>> A(this->samples, vector<double>(d)), B(this->samples, vector<double>(d));
+    for (int j = 0; j < this->samples; j++) {
+        vector<double> u = sequence.point(j + 1);
+        for (int i = 0; i < d; i++) {
+            const Parameter& p = this->parameters[i];
+            A[j][i] = p.low + (p.high - p.low) * u[i];
+            B[j][i] = p.low + (p.high - p.low) * u[d + i];
+        }
+    }
+    auto value = [&](long long k, int i) { // 第 k 次模擬的第 i 個參數值 (欄 1 與欄 2 + i 取自 B)
+        int j = k / columns, c = k % columns;
+        return c == 1 || c == 2 + i ? B[j][i] : A[j][i];
+    };
+
+    vector<Outcome> results(runs);
+    vector<toml::table> tables(min<long long>(this->threads, runs), Experiment::batch(this->config)); // 各執行緒的設定
+    vector<pair<string, string>> fields; // 各參數所在的區段與欄位名稱
+    for (auto& p : this->parameters) {
+        size_t dot = p.key.find('.');
+        fields.emplace_back(p.key.substr(0, dot), p.key.substr(dot + 1));
+    }
+    Experiment::parallelFor(this->threads, runs, [&](long long k, int t) {
+        toml::table& table = tables[t];
+        table["general"].as_table()->insert_or_assign("seed", static_cast<int64_t>(this->baseSeed + k / columns));
+        for (int i = 0; i < d; i++) {
+            toml::table* section = table[fields[i].first].as_table();
+            if (this->integer[i]) section->insert_or_assign(fields[i].second, static_cast<int64_t>(llround(value(k, i))));
+            else section->insert_or_assign(fields[i].second, value(k, i));
+        }
+        auto system = make_unique<System>();
+        system->init(table);
+        system->simulation();
+        results[k] = Outcome::of(*system);
+        return true;
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!this->outputPath.empty()) {
+        BufferedWriter file;
+        file.open(this->outputPath);
+        file << "run,row,matrix";
+        for (auto& p : this->parameters) file << "," << p.key;
+        for (auto* name : Outcome::names) file << "," << name;
+        file << "\n";
+        for (long long k = 0; k < runs; k++) {
+            int c = k % columns;
+            file << k << "," << k / columns << "," << (c == 0 ? "A" : c == 1 ? "B" : "AB" + to_string(c - 2));
+            for (int i = 0; i < d; i++) file << "," << value(k, i);
+            for (double v : results[k].values) file << "," << v;
+            file << "\n";
+        }
+        file.close();
+    }
+
+    cout << ">>> Sobol sensitivity analysis <<<\n";
+    cout << "Parameters: " << d << ", base samples: " << this->samples << ", runs: " << runs << " (seeds " << this->baseSeed
+         << " .. " << this->baseSeed + this->samples - 1 << ")\n";
+    cout << fixed << setprecision(2) << "Time: " << seconds << " s, " << runs / max(seconds, 1e-9) << " simulations/s; "
+         << this->bootstrap << " bootstrap resamples for 95% intervals\n";
+    for (int m = 0; m < Outcome::count; m++) {
+        Welford all;
+        for (int j = 0; j < this->samples; j++) {
+            all.add(results[static_cast<size_t>(j) * columns].values[m]);
+            all.add(results[static_cast<size_t>(j) * columns + 1].values[m]);
+        }
+        vector<SobolIndex> index = this->indices(results, m);
+        cout << "\n" << Outcome::names[m] << setprecision(4) << " (mean " << all.mean << ", sd " << all.sd() << ")\n";
+        cout << "  " << left << setw(22) << "parameter" << setw(20) << "range" << right << setw(22) << "first-order"
+             << setw(22) << "total" << "\n";
+        double sum = 0;
+        for (int i = 0; i < d; i++) {
+            const Parameter& p = this->parameters[i];
+            ostringstream range;
+            range << "[" << defaultfloat << p.low << ", " << p.high << "]";
+            cout << "  " << left << setw(22) << p.key << setw(20) << range.str() << right << setw(10) << index[i].first << " +/- "
+                 << setw(7) << index[i].firstHalfWidth << setw(10) << index[i].total << " +/- " << setw(7) << index[i].totalHalfWidth << "\n";
+            sum += index[i].first;
+        }
+        cout << "  sum of first-order indices " << sum << " (the rest is interactions and simulation noise)\n";
+    }
+    cout << defaultfloat;
+}
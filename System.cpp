@@ -1,27 +1,32 @@
 #include "System.hpp"
+#include "Checkpoint.hpp"
 #include "toml.hpp"
 #include <iomanip>
 #include <sstream>
 
 System::System() : route(mileageCmp()) {
 /**
- * @brief 模擬系統建構子，初始化事件處理設置並開始模擬過程
+ * @brief 模擬系統建構子
  * 
- * 這個建構子會初始化模擬系統的基本設定，並自動設定每一種類型事件對應的處理函式（即事件集）。
- * 它使用 `eventSet` 來映射事件類型與對應的事件處理函式，並且在初始化完成後開始模擬過程。
+ * 事件種類與處理函式的對應直接寫在 `simulation` 的 switch 中 (編譯期分派，可內聯)，
+ * 建構子不需再建立事件集。
  * 
  */
-    /* 初始化一個模擬系統時，自動設定 event set 的 mapping */
-    eventSet[1] = [this](Event* e) { this->arriveAtStop(e); }; // 事件 1: 公車到站
-    eventSet[2] = [this](Event* e) { this->deptFromStop(e); }; // 事件 2: 公車離站
-    eventSet[3] = [this](Event* e) { this->arriveAtLight(e); }; // 事件 3: 公車到號誌化路口
-    eventSet[4] = [this](Event* e) { this->deptFromLight(e); }; // 事件 4: 公車離開號誌化路口
-
     cout << "Start simulation process...\n";
 }
 
 const int System::getTmax() { return this->Tmax.value(); }
 
+vector<int> System::getStopMileages() const {
+    vector<int> mileages(this->stopAmount);
+    for (auto& stop : this->stops) mileages[stop.id] = stop.mileage;
+    return mileages;
+}
+
+SpeedAdvisor System::getAdvisor() const {
+    return { this->Vlow.value() / 3.6, this->Vlimit.value() / 3.6, this->schemeThreshold.value() };
+}
+
 optional<Stop*> System::getNextStop(int stopID) { return findNextStop(stopID); }
 
 optional<Stop*> System::findNextStop(int stopID) {
@@ -35,6 +40,7 @@ optional<Stop*> System::findNextStop(int stopID) {
  * @param stopID 目標站牌的編號
  * @return optional<Stop*> 若找到下一站，則回傳 `Stop*`；否則回傳 `nullopt`
  */
+    PROFILE_SCOPE(profile, Section::FindNextStop);
     for (auto it = route.begin(); it != route.end(); ++it) { // 遍歷路線上的元素
         if (auto* stop = get_if<Stop*>(&*it)) { // 如果抓到一個 stop
             if ((*stop)->id == stopID) { // 若這個 stop 的編號是函式傳入的 id
@@ -45,7 +51,7 @@ optional<Stop*> System::findNextStop(int stopID) {
                     }
                     ++nextIt;
                 }
-                cout << "No next Stop found after stopID: " << stopID << endl; // 沒有找到下一站
+                out << "No next Stop found after stopID: " << stopID << endl; // 沒有找到下一站
                 return nullopt; // 回傳空指標
             }
         }
@@ -64,6 +70,7 @@ optional<variant<Stop*, Light*>> System::findNext(variant<Stop*, Light*> target)
  * @param target 目標元素 (`Stop*` 或 `Light*`)
  * @return optional<variant<Stop*, Light*>> 若找到下一個元素，則回傳 `Stop*` 或 `Light*`；否則回傳 `nullopt`
  */
+    PROFILE_SCOPE(profile, Section::FindNext);
     auto it = route.find(target); // 找到目標元素的位置
     it++; // 位置 +1
     if (holds_alternative<Stop*>(*it)) { // 若為站點
@@ -92,15 +99,19 @@ void System::incrHeadwayDev(float t) {
 
 void System::printFormattedTime(int seconds) {
 /**
- * @brief 格式化輸出時間（以 HH:MM:SS 方式顯示）
+ * @brief 格式化輸出時間（以 HH:MM:SS 方式顯示，多日模擬時於第二天起加上日數）
  * @param seconds 時間（以秒為單位）
  */   
-    cout << setw(2) << setfill('0') << seconds / 3600 << ":" 
+    if (seconds >= 86400) {
+        out << "Day " << seconds / 86400 + 1 << " ";
+        seconds %= 86400;
+    }
+    out << setw(2) << setfill('0') << seconds / 3600 << ":" 
          << setw(2) << setfill('0') << (seconds % 3600) / 60 << ":" 
          << setw(2) << setfill('0') << seconds % 60;
 }
 
-void System::printEventDetails(Event* e) {
+void System::printEventDetails(const Event& e) {
 /**
  * @brief 印出公車事件的詳細資訊
  * 
@@ -113,23 +124,24 @@ void System::printEventDetails(Event* e) {
  *       - 1: 公車離開站牌
  *       - 2: 公車到達號誌
  *       - 3: 公車離開號誌
+ *       - 5: 公車進入停靠席位 (排隊後)
  * 
  * @see System::printFormattedTime(int) 用於格式化時間輸出
  */
-    const char* arrivalStatus[] = { " arrived at ", " departed from ", " arrived at ", " departed from " };
-    const char* locationType[] = { "stop ", "stop ", "signal ", "signal "};
-
-    cout << "\nTime: ";
-    printFormattedTime(e->getTime());
-    cout << "\n";
-
-    cout << "New Event: Bus " << e->getBusID() 
-         << arrivalStatus[e->getEventType() - 1]
-         << locationType[e->getEventType() - 1];
-    if (e->getEventType() == 1 || e->getEventType() == 2) {
-        cout << e->getStopID() << "\n\n";
+    const char* arrivalStatus[] = { " arrived at ", " departed from ", " arrived at ", " departed from ", "", " entered a berth at " };
+    const char* locationType[] = { "stop ", "stop ", "signal ", "signal ", "", "stop " };
+
+    out << "\nTime: ";
+    printFormattedTime(e.getTime());
+    out << "\n";
+
+    out << "New Event: Bus " << e.getBusID() 
+         << arrivalStatus[e.getEventType() - 1]
+         << locationType[e.getEventType() - 1];
+    if (e.getEventType() == 1 || e.getEventType() == 2 || e.getEventType() == 6) {
+        out << e.getStopID() << "\n\n";
     } else {
-        cout << e->getLightID() << "\n\n";
+        out << e.getLightID() << "\n\n";
     }
 }
 
@@ -170,8 +182,8 @@ pair<int, int> System::timeRange2Pair(const string& timeStr){
             throw runtime_error("時間格式錯誤: " + timeStr);
         }
 
-        int time = stoi(timeStr); // 轉換為整數
-        return {time, time + 59*60}; // 回傳 (開始時間, 結束時間) 一樣
+        int time = time2Seconds(timeStr); // 轉換為秒數
+        return {time, time + 59*60}; // 回傳 (開始時間, 結束時間)
     } else { 
         // **[情況 2]** 有 "-"，代表時間範圍，例如 "1830-1900"
 
@@ -205,22 +217,22 @@ void System::displayRoute() {
  * `route` 容器中存儲的是 `std::variant<Stop*, Light*>`，因此使用 `std::visit` 來處理不同類型的物件。
  */
     for (auto& element : this->route) { // 遍歷 route 中的元素
-        visit([](auto&& obj) {
+        visit([this](auto&& obj) {
             using T = decay_t<decltype(obj)>;
             if constexpr (is_same_v<T, Stop*>) {
-                cout << "Stop ID: " << obj->id << " " << obj->stopName << endl;
+                out << "Stop ID: " << obj->id << " " << obj->stopName << endl;
             } else if constexpr (is_same_v<T, Light*>) {
-                cout << "Signal ID: " << obj->id <<  " " << obj->lightName << endl;
+                out << "Signal ID: " << obj->id <<  " " << obj->lightName << endl;
             }
         }, element);
     }
 }
 
-void System::init() {
+void System::init(const string& configPath) {
 /**
- * @brief 初始化系統並讀取設定檔 (config.toml)
+ * @brief 初始化系統並讀取設定檔 (預設為 config.toml)
  * 
- * 此函式從 `config.toml` 讀取各種設定，包括：
+ * 此函式從設定檔讀取各種設定，包括：
  * - 路線資訊
  * - 站點與號誌參數
  * - 班表資訊
@@ -230,57 +242,188 @@ void System::init() {
  */
     /* 讀取設定檔 */
     try {
-        auto config = toml::parse_file( "config.toml" ); // 讀取 general 設定檔
+        this->init(toml::parse_file( configPath ));
+    } catch (const toml::parse_error& e) {
+        cerr << "設定檔讀取錯誤：" << e.what() << "\n";
+        exit(1);
+    }
+}
 
-        /* 讀取路線基本資料 */
-        this->routeName = config["general"]["route"].value_or("Testcase");
+void System::init(const toml::table& config) {
+/**
+ * @brief 以已讀入的設定初始化系統
+ *
+ * 重複實驗與策略比較可先讀入一次設定檔，修改部分欄位 (例如 `general.seed`) 後再初始化，
+ * 不需為每次模擬寫出暫存設定檔。
+ *
+ * @param config 設定 (格式同 config.toml)
+ */
+    /* 讀取路線基本資料 */
+    this->routeName = config["general"]["route"].value_or("Testcase");
+    this->dataDir = config["general"]["dataDir"].value_or("./data");
+    this->seedStreams(config["general"]["seed"].value<int64_t>()); // 未指定種子時以 random_device 產生
+    this->antithetic = config["general"]["antithetic"].value_or(false);
+
+    auto peakOpt = config["general"]["morningPeak"].value<string>();
+    if (!peakOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'general.morningPeak' 欄位");
+    this->morningPeak = timeRange2Pair(*peakOpt);
+
+    peakOpt = config["general"]["eveningPeak"].value<string>();
+    if (!peakOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'general.eveningPeak' 欄位");
+    this->eveningPeak = timeRange2Pair(*peakOpt);
+
+    /* 讀取星期設定: 起始日 (1 = 週一 ... 7 = 週日)、各日需求倍率及有尖峰時段的日子 */
+    this->startDay = config["general"]["startDay"].value_or(1);
+    if (this->startDay < 1 || this->startDay > 7) throw runtime_error("錯誤: 'general.startDay' 必須介於 1 到 7 之間");
+    this->dayFactor.fill(1.0);
+    if (auto factors = config["demand"]["dayFactor"].as_array()) {
+        if (factors->size() != 7) throw runtime_error("錯誤: 'demand.dayFactor' 必須有 7 個數值 (週一至週日)");
+        for (size_t i = 0; i < 7; i++) this->dayFactor[i] = factors->get(i)->value_or(1.0);
+    }
+    double demandScale = config["demand"]["scale"].value_or(1.0); // 整體需求倍率 (乘上各日倍率)
+    if (demandScale < 0) throw runtime_error("錯誤: 'demand.scale' 不得為負值");
+    for (auto& factor : this->dayFactor) factor *= demandScale;
+    this->peakDays.fill(true);
+    if (auto peak = config["demand"]["peakDays"].as_array()) {
+        this->peakDays.fill(false);
+        for (auto& day : *peak) {
+            int d = day.value_or(0);
+            if (d < 1 || d > 7) throw runtime_error("錯誤: 'demand.peakDays' 的數值必須介於 1 到 7 之間");
+            this->peakDays[d - 1] = true;
+        }
+    }
+    
 
-        auto peakOpt = config["general"]["morningPeak"].value<string>();
-        if (!peakOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'general.morningPeak' 欄位");
-        this->morningPeak = timeRange2Pair(*peakOpt);
+    /* 讀取站點參數及站點檔案 */
+    this->stopDistAvg = config["stop"]["distAvg"].value<double>();
+    this->stopDistSd = config["stop"]["distSd"].value<double>();
+    this->setupStop(this->stopDistAvg.value(), this->stopDistSd.value());
+    this->stopState.resize(this->stopAmount);
+    for (auto& stop : this->stops) {  // 終點站不限制席位 (車輛抵達後即退出營運，不會離站)
+        if (stop.id < this->stopAmount - 1) this->stopState.berth[stop.id].berths = stop.berths;
+    }
 
-        peakOpt = config["general"]["eveningPeak"].value<string>();
-        if (!peakOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'general.eveningPeak' 欄位");
-        this->eveningPeak = timeRange2Pair(*peakOpt);
-        
+    /* 讀取號誌參數及號誌描述檔 */
+    this->signalDistAvg = config["signal"]["distAvg"].value<double>();
+    this->signalDistSd = config["signal"]["distSd"].value<double>();
+    this->setupSignal(this->signalDistAvg.value(), this->signalDistSd.value());
+    double cycleScale = config["signal"]["cycleScale"].value_or(1.0); // 時制週期倍率 (綠燈比不變)
+    if (cycleScale <= 0) throw runtime_error("錯誤: 'signal.cycleScale' 必須大於 0");
+    if (cycleScale != 1) {
+        for (auto& light : this->lights) {
+            for (auto& plan : light.plans) plan.scale(cycleScale);
+        }
+    }
 
-        /* 讀取站點參數及站點檔案 */
-        this->stopDistAvg = config["stop"]["distAvg"].value<double>();
-        this->stopDistSd = config["stop"]["distSd"].value<double>();
-        this->setupStop(this->stopDistAvg.value(), this->stopDistSd.value());
-
-        /* 讀取號誌參數及號誌描述檔 */
-        this->signalDistAvg = config["signal"]["distAvg"].value<double>();
-        this->signalDistSd = config["signal"]["distSd"].value<double>();
-        this->setupSignal(this->signalDistAvg.value(), this->signalDistSd.value());
-
-        /*讀取班表分佈參數並產生班表*/
-        auto startTimeOpt = config["schedule"]["startTime"].value<string>();
-        if (!startTimeOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'schedule.startTime' 欄位");
-        this->scheStart = time2Seconds(*startTimeOpt);
-
-        this->shift = config["schedule"]["shift"].value<int>();
-        this->scheAvg = config["schedule"]["avg"].value<double>();
-        this->scheAvg.value() *= 60;
-        this->scheSd = config["schedule"]["sd"].value<double>();
-        this->scheSd.value() *= 60;
-        this->setupSche(this->scheStart.value(), this->scheAvg.value(), this->scheSd.value(), this->shift.value());
-
-        /* 讀取速度相關參數 */
-        this->Vavg = config["velocity"]["avg"].value<double>();
-        this->Vsd = config["velocity"]["sd"].value<double>();
-        this->Vlimit = config["velocity"]["limit"].value<double>();
-        this->Vlow = config["velocity"]["low"].value<double>();
-
-        /* 讀取時間相關參數 */
-        this->Tmax = config["time"]["Tmax"].value<int>();
-        this->schemeThreshold = config["time"]["schemeThreshold"].value<double>();
+    /* 讀取路口一般車流設定: 車流量大於 0 的號誌於紅燈後須等前方停等車輛紓解 (各號誌可於 signals.csv 覆寫) */
+    double volume = config["signal"]["volume"].value_or(0.0);
+    double saturation = config["signal"]["saturation"].value_or(1800.0);
+    int lostTime = config["signal"]["lostTime"].value_or(2);
+    if (lostTime < 0) throw runtime_error("錯誤: 'signal.lostTime' 不得為負值");
+    this->signalQueue.assign(this->lights.size(), SignalQueue());
+    for (auto& light : this->lights) {
+        auto& queue = this->signalQueue[light.id];
+        double q = light.volume >= 0 ? light.volume : volume;
+        double s = light.saturation >= 0 ? light.saturation : saturation;
+        if (q <= 0) continue;
+        if (s <= 0) throw runtime_error("錯誤: 號誌 " + light.lightName + " 的飽和流率必須大於 0");
+        queue.arrival = q / 3600;
+        queue.discharge = s / 3600;
+        queue.lostTime = lostTime;
+    }
+    this->lastPass.assign(this->stopAmount + this->lights.size(), -1);
+
+    /*讀取班表分佈參數並產生班表*/
+    auto startTimeOpt = config["schedule"]["startTime"].value<string>();
+    if (!startTimeOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'schedule.startTime' 欄位");
+    this->scheStart = time2Seconds(*startTimeOpt);
+
+    auto endTimeOpt = config["schedule"]["endTime"].value<string>();
+    if (!endTimeOpt) throw runtime_error("錯誤: TOML 描述檔缺少 'schedule.endTime' 欄位");
+    this->scheEnd = time2Seconds(*endTimeOpt);
+    if (this->scheEnd.value() <= this->scheStart.value()) this->scheEnd.value() += 86400; // 末班車跨午夜
+
+    this->days = config["schedule"]["days"].value_or(1);
+    if (this->days < 1 || this->days > 3650) throw runtime_error("錯誤: 'schedule.days' 必須介於 1 到 3650 之間");
+    this->shift = config["schedule"]["shift"].value<int>();
+    this->scheAvg = config["schedule"]["avg"].value<double>();
+    this->scheAvg.value() *= 60;
+    this->scheSd = config["schedule"]["sd"].value<double>();
+    this->scheSd.value() *= 60;
+    this->scheFile = config["schedule"]["file"].value_or("");
+    string gtfsDir = config["schedule"]["gtfs"].value_or("");
+    if (!this->scheFile.empty()) { // 指定班表檔案時，改為讀取檔案中的班表
+        this->readSche(config["schedule"]["trial"].value_or(0));
+    } else if (!gtfsDir.empty()) { // 指定 GTFS feed 時，改為讀取實際公告的班表
+        this->readGtfs(this->dataDir + "/" + gtfsDir,
+                       config["schedule"]["gtfsRoute"].value_or(this->routeName),
+                       config["schedule"]["gtfsDirection"].value_or(-1),
+                       config["schedule"]["gtfsService"].value_or(""));
+    } else {
+        this->setupSche(this->scheStart.value(), this->scheAvg.value(), this->scheSd.value(), this->shift.value_or(INT_MAX));
+    }
 
-    } catch (const toml::parse_error& e) {
-        cerr << "設定檔讀取錯誤：" << e.what() << "\n";
-        exit(1);
+    /* 讀取速度相關參數 */
+    this->Vavg = config["velocity"]["avg"].value<double>();
+    this->Vsd = config["velocity"]["sd"].value<double>();
+    this->Vlimit = config["velocity"]["limit"].value<double>();
+    this->Vlow = config["velocity"]["low"].value<double>();
+
+    /* 讀取時間相關參數 */
+    this->Tmax = config["time"]["Tmax"].value<int>();
+    this->schemeThreshold = config["time"]["schemeThreshold"].value<double>();
+
+    /* 讀取控制策略: 策略二 (滾動時域預測控制) 的參數位於 [mpc] 區段 */
+    this->scheme = config["general"]["scheme"].value_or(1);
+    if (this->scheme != 1 && this->scheme != 2) throw runtime_error("錯誤: 'general.scheme' 必須為 1 或 2");
+    this->horizon.stops = config["mpc"]["horizon"].value_or(8);
+    this->horizon.window = config["mpc"]["window"].value_or(2);
+    this->horizon.speeds = config["mpc"]["speeds"].value_or(5);
+    this->horizon.holds = config["mpc"]["holds"].value_or(4);
+    this->horizon.holdStep = config["mpc"]["holdStep"].value_or(20);
+    if (this->horizon.stops < 1 || this->horizon.window < 0 || this->horizon.speeds < 1 || this->horizon.holds < 1 || this->horizon.holdStep < 0) {
+        throw runtime_error("錯誤: 'mpc' 的 horizon、speeds、holds 必須至少為 1，window、holdStep 不可為負");
+    }
+    this->horizon.Vavg = this->Vavg.value() / 3.6;
+    this->horizon.capacity = FleetState::capacity;
+
+    /* 讀取跟車設定: 禁止超車時，後車抵達下一元素的時間不早於前車加最小時距 */
+    this->overtaking = config["velocity"]["overtaking"].value_or(true);
+    this->minGap = config["velocity"]["minGap"].value_or(3);
+    if (this->minGap < 1) throw runtime_error("錯誤: 'velocity.minGap' 必須至少 1 秒");
+
+    /* 讀取路段速度表: 各路段依時段的背景車流速度 (kph)，公車在該路段的速度不超過此值 */
+    string linkSpeedFile = config["velocity"]["linkSpeeds"].value_or("");
+    if (!linkSpeedFile.empty()) this->linkSpeed.load(this->dataDir + "/" + linkSpeedFile, this->stopAmount, this->lights.size());
+
+    /* 讀取輸出設定 */
+    this->summaryPath = config["output"]["summary"].value_or("summary.json");
+    this->trajectoryPath = config["output"]["trajectory"].value_or("");
+    this->out.enabled = config["output"]["verbose"].value_or(true);
+    this->compression = config["output"]["compression"].value_or(100.0);
+    this->tracePath = config["output"]["trace"].value_or("");
+    this->queuePath = config["output"]["queues"].value_or("");
+    this->queueInterval = config["output"]["queueInterval"].value_or(60);
+    if (this->queueInterval <= 0) throw runtime_error("錯誤: 'output.queueInterval' 必須大於 0");
+    this->metrics.resize(this->stopAmount, this->fleet.size(), this->compression.value()); // 依站點及車輛數配置績效累積器
+
+    /* 讀取檢查點設定: 於指定時刻儲存，或自檢查點接續模擬 */
+    this->checkpointPath = config["checkpoint"]["save"].value_or("");
+    if (!this->checkpointPath.empty()) {
+        auto atOpt = config["checkpoint"]["at"].value<string>();
+        if (!atOpt) throw runtime_error("錯誤: 指定 'checkpoint.save' 時必須設定 'checkpoint.at'");
+        this->checkpointAt = time2Seconds(*atOpt) + (config["checkpoint"]["day"].value_or(1) - 1) * 86400;
+        this->checkpointStop = config["checkpoint"]["stop"].value_or(false);
+    }
+    string restorePath = config["checkpoint"]["restore"].value_or("");
+    if (!restorePath.empty()) {
+        this->loadCheckpoint(restorePath);
+        if (config["checkpoint"]["reseed"].value_or(false)) { // 接續後改用新的需求與速度亂數 (分支出不同的隨機未來)
+            this->seedStreams(config["general"]["seed"].value<int64_t>());
+        }
     }
 
+    this->horizon.mileage = this->getStopMileages();
     this->displayRoute();
 
 }
@@ -290,9 +433,9 @@ void System::setupStop(double avg, double sd) {
  * @brief 讀取站點資訊檔案 (stops.csv) 並初始化站點資料
  *
  * 此函式會執行以下步驟：
- * 1. 讀取 `./data/stops.csv` 檔案，解析每個站點的資料。
- * 2. 生成符合 **常態分佈 (Normal Distribution)** 的站距 (mileage)。
- * 3. 設定站點名稱、乘客到站率 (`arrivalRate`)、乘客下車率 (`dropRate`)。
+ * 1. 讀取 `general.dataDir` (預設 `./data`) 下的 `stops.csv` 檔案，解析每個站點的資料。
+ * 2. 生成符合 **常態分佈 (Normal Distribution)** 的站距 (mileage)；第 15 欄指定實際里程時直接使用。
+ * 3. 設定站點名稱、乘客到站率 (`arrivalRate`)、乘客下車率 (`dropRate`)、停靠席位數 (第 14 欄)。
  * 4. 將解析出的 `Stop` 物件插入 `route` 容器內。
  *
  * @param avg 站距的平均值 (meters)
@@ -301,16 +444,14 @@ void System::setupStop(double avg, double sd) {
     /* 初始化變數 */
     string line;
     double current_distance = 0.0, next_distance; // 累積的總距離
-    random_device rd;
-    mt19937 gen(rd()); // 隨機數生成器
     normal_distribution<> dist(avg, sd); // 常態分佈，均值 avg，標準差 sd
 
     this->stopAmount = 0; // 記錄站點數量
     int id = 0; // 站點 ID
 
-    ifstream file("./data/stops.csv"); // 開啟站點資訊檔案
+    ifstream file(this->dataDir + "/stops.csv"); // 開啟站點資訊檔案
     if (!file) {
-        throw runtime_error("無法開啟./data/stops.csv\n");
+        throw runtime_error("無法開啟" + this->dataDir + "/stops.csv\n");
     }
 
     double tmpAvg, tmpSd; // 暫存讀取的平均值與標準差
@@ -321,7 +462,7 @@ void System::setupStop(double avg, double sd) {
     while (getline(file, line)) {
         stringstream ss(line); // 使用 stringstream 解析 CSV 行
         string field;
-        Stop* stop = new Stop; // 創建新的 Stop 物件
+        Stop* stop = &this->stops.emplace_back(); // 創建新的 Stop 物件
 
         stop->id = id; // 設定站點 ID
 
@@ -347,22 +488,41 @@ void System::setupStop(double avg, double sd) {
             stop->dropRate[i] = make_pair(tmpAvg, tmpSd); // 存入下車率
         }
 
+        /* 讀取停靠席位數 (選填欄位) */
+        if (getline(ss, field, ',') && !field.empty() && field != "\r") {
+            stop->berths = stoi(field);
+            if (stop->berths < 0 || stop->berths >= BerthQueue::capacity) {
+                throw runtime_error("站點 " + stop->stopName + " 的停靠席位數必須介於 0 到 " + to_string(BerthQueue::capacity - 1) + " 之間");
+            }
+        }
+
+        /* 讀取實際里程 (選填欄位，公尺)；指定時不抽樣站距 (例如 AVL 重播須與實際路線一致) */
+        if (getline(ss, field, ',') && !field.empty() && field != "\r") {
+            stop->mileage = stoi(field);
+            if (stop->mileage < current_distance || (stop->id > 0 && stop->mileage == current_distance) || !route.insert(stop).second) {
+                throw runtime_error("站點 " + stop->stopName + " 的里程必須大於前一站");
+            }
+            current_distance = stop->mileage;
+            this->stopAmount++;
+            id++;
+            continue;
+        }
+
         /* 計算站點的里程數 (mileage) */
         if (stop->id == 0) {
             stop->mileage = 0; // 第一個站點的里程數為 0
         } else {
-            next_distance = max(0.0, dist(gen)); // 生成符合常態分佈的距離，確保不小於 0
+            next_distance = max(0.0, this->sample(dist, routeGen)); // 生成符合常態分佈的距離，確保不小於 0
             current_distance += next_distance; // 累加站距
             stop->mileage = current_distance; // 設定站點的累積里程
         }
 
-        /* 將站點加入路線容器 */
+        /* 將站點加入路線容器 (里程與既有元素重複時重新抽樣站距，由迴圈條件再次嘗試插入；不可在迴圈內插入，否則會修改已在容器中的鍵值) */
         while (route.insert(stop).second == false) {
             current_distance -= next_distance;
-            next_distance = max(0.0, dist(gen)); 
+            next_distance = max(0.0, this->sample(dist, routeGen)); 
             current_distance += next_distance;
             stop->mileage = current_distance;
-            route.insert(stop);
         }
         this->stopAmount++; // 更新站點數量
         id++; // 站點 ID 遞增
@@ -376,9 +536,10 @@ void System::setupSignal(double avg, double sd) {
  * @brief 讀取號誌資訊檔案 (signals.csv) 並初始化號誌資料
  *
  * 此函式會執行以下步驟：
- * 1. 讀取 `./data/signals.csv` 檔案，解析每個號誌的資料。
+ * 1. 讀取 `general.dataDir` (預設 `./data`) 下的 `signals.csv` 檔案，解析每個號誌的資料。
  * 2. 生成符合 **常態分佈 (Normal Distribution)** 的號誌距離 (mileage)。
- * 3. 設定號誌名稱 (`lightName`)、時相資訊 (`plan.setPhase`)。
+ * 3. 設定號誌名稱 (`lightName`)、各日時相資訊 (`plans`，`Plan::setPhase`)，
+ *    以及時制之後可選填的一般車流量與飽和流率 (`volume`, `saturation`；輛/小時)。
  * 4. 確保號誌的 `mileage` 值不與其他站點或號誌重疊。
  *
  * @param avg 號誌間距的平均值 (meters)
@@ -388,13 +549,11 @@ void System::setupSignal(double avg, double sd) {
     string line;
     double current_distance = 0.0, next_distance; // 累積的總距離
     int id = 0; // 號誌 ID
-    random_device rd;
-    mt19937 gen(rd()); // 隨機數生成器
-    ifstream file("./data/signals.csv"); // 開啟號誌資訊檔案
+    ifstream file(this->dataDir + "/signals.csv"); // 開啟號誌資訊檔案
 
     /* 檢查檔案是否成功開啟 */
     if (!file) {
-        throw runtime_error("Can't open ./data/signals.csv"); // 若無法開啟檔案，拋出例外
+        throw runtime_error("Can't open " + this->dataDir + "/signals.csv"); // 若無法開啟檔案，拋出例外
     }
 
     getline(file, line); // 跳過 CSV 檔案的標題行
@@ -403,7 +562,7 @@ void System::setupSignal(double avg, double sd) {
     while (getline(file, line)) {
         stringstream ss(line); // 使用 stringstream 解析 CSV 行
         string field;
-        Light* light = new Light; // 創建新的 Light 物件 (代表一個號誌)
+        Light* light = &this->lights.emplace_back(); // 創建新的 Light 物件 (代表一個號誌)
 
         /* 讀取號誌 ID */
         getline(ss, field, ',');
@@ -413,23 +572,38 @@ void System::setupSignal(double avg, double sd) {
         getline(ss, field, ',');
         light->lightName = field;
 
-        /* 讀取並設定號誌時相 (phase) */
+        /* 讀取並設定號誌時相 (phase)；以 '|' 分隔多組時制: 一組全週共用、兩組為平日|週末、七組為週一至週日 */
         getline(ss, field);
-        light->plan.setPhase(field);
+        size_t planEnd = field.rfind('/');  // 時制之後可選填一般車流量與飽和流率 (輛/小時)
+        if (planEnd != string::npos && planEnd + 1 < field.size() && field[planEnd + 1] == ',') {
+            stringstream extra(field.substr(planEnd + 2));
+            string value;
+            if (getline(extra, value, ',') && !value.empty()) light->volume = stod(value);
+            if (getline(extra, value, ',') && !value.empty()) light->saturation = stod(value);
+            field.erase(planEnd + 1);
+        }
+        stringstream planStream(field);
+        string planField;
+        while (getline(planStream, planField, '|')) {
+            light->plans.emplace_back();
+            light->plans.back().setPhase(planField);
+        }
+        if (light->plans.size() != 1 && light->plans.size() != 2 && light->plans.size() != 7) {
+            throw runtime_error("號誌 " + light->lightName + " 的時制組數必須為 1、2 或 7");
+        }
 
         /* 計算號誌的里程數 (mileage) */
         normal_distribution<> dist(avg, sd); // 產生符合常態分佈的號誌距離
-        next_distance = max(0.0, dist(gen)); // 確保距離不小於 0
+        next_distance = max(0.0, this->sample(dist, routeGen)); // 確保距離不小於 0
         current_distance += next_distance; // 累計距離
         light->mileage = current_distance; // 設定號誌的里程數
 
         /* 確保號誌的 mileage 不與其他站點/號誌重疊 */
         while (route.insert(light).second == false) { // 若 `insert` 失敗 (代表已有相同里程的站點或號誌)
             current_distance -= next_distance; // 回退上次的距離變更
-            next_distance = max(0.0, dist(gen)); // 重新產生新的距離
+            next_distance = max(0.0, this->sample(dist, routeGen)); // 重新產生新的距離
             current_distance += next_distance; // 更新累積距離
-            light->mileage = current_distance; // 設定新的里程數
-            route.insert(light); // 嘗試再次插入
+            light->mileage = current_distance; // 設定新的里程數 (由迴圈條件再次嘗試插入)
         }
 
         id++; // 號誌 ID 遞增
@@ -443,9 +617,11 @@ void System::setupSche(int startTime, double avg, double sd, int shift) {
  * @brief 初始化班表 (Schedule) 並生成車輛與事件
  *
  * 此函式會執行以下步驟：
- * 1. 透過 `startTime` 設定首班車時間 (`currentTime`)。
+ * 1. 透過 `startTime` 設定每日首班車時間 (`currentTime`)。
  * 2. 根據 **常態分佈 (Normal Distribution)** 產生車輛發車間距 (`hdwy`)。
- * 3. 根據 `shift` 參數決定發車班次，並建立:
+ * 3. 每日持續發車至末班車時間 (`schedule.endTime`) 為止，`shift` 為每日班次上限；
+ *    超過末班車時間後仍抽樣至 `shift` 次 (不發車)，原始抽樣值的期望值因此不受截斷影響，可作為控制變數；
+ *    共產生 `schedule.days` 天的班次，並建立:
  *    - **班表 (`sche`)**
  *    - **車輛 (`fleet`)**
  *    - **對應事件 (`eventList`)**
@@ -453,65 +629,309 @@ void System::setupSche(int startTime, double avg, double sd, int shift) {
  * @param startTime 首班車時間 (秒)
  * @param avg 發車間距的平均值 (秒)
  * @param sd 發車間距的標準差 (秒)
- * @param shift 總發車班次數
+ * @param shift 每日發車班次上限
  */
-    int currentTime = startTime, hdwy = 0; // 當前時間 (currentTime) 與發車間距 (hdwy)
-    random_device rd;
-    mt19937 gen(rd()); // 隨機數生成器
     normal_distribution<> dist(avg, sd); // 產生符合常態分佈的發車間距
+    int endTime = this->scheEnd.value(); // 末班車時間 (秒)
+    fleet.reserve(min<long long>(shift, (endTime - startTime) / max(1.0, avg) + 1) * this->days); // 預先配置車隊狀態陣列
+
+    for (int day = 0; day < this->days; day++) {
+        int currentTime = startTime + day * 86400, hdwy = 0; // 當前時間 (currentTime) 與發車間距 (hdwy)
+
+        /* 發車至末班車時間或達到每日班次上限為止 */
+        bool ended = false; // 是否已超過末班車時間
+        for (int i = 0; i < shift; i++) {
+            double draw = this->sample(dist, scheduleGen);
+            this->scheduleDraws.push_back(draw);
+            if (ended) continue;
+            hdwy = max(1, static_cast<int>(abs(draw))); // 產生隨機發車間距 (取絕對值避免負數，至少 1 秒以免班距偏差除以 0)
+            
+            if (i > 0) { // 從第二班車開始，將發車間距加到當前時間
+                currentTime += hdwy;
+            }
+            if (currentTime > endTime + day * 86400) { // 超過末班車時間
+                ended = true;
+                continue;
+            }
 
-    /* 根據班次數量 (shift) 進行迴圈 */
-    for (int i = 0; i < this->shift.value(); i++) {
-        hdwy = abs(dist(gen)); // 產生隨機發車間距 (取絕對值避免負數)
-        
-        if (i > 0) { // 從第二班車開始，將發車間距加到當前時間
-            currentTime += hdwy;
+            this->addTrip(currentTime, hdwy); // 記錄發車時間並建立車輛與發車事件
         }
+    }
+}
 
-        this->sche.push_back(currentTime); // 記錄發車時間
+void System::readSche(int trial) {
+/**
+ * @brief 從班表檔案 (`dataDir` 下的 `schedule.file`) 讀取指定組別的班表，並生成車輛與事件
+ *
+ * 檔案欄位為 trial (班表組別), trip (班次編號), departure (發車時間，秒), headway (與前一班的間距，秒)。
+ * 同一檔案可存放多組預先抽樣的班表，供不同重複實驗使用。
+ *
+ * @param trial 班表組別
+ * @throws runtime_error 若無法開啟檔案或找不到該組別的班次
+ */
+    ifstream file(this->dataDir + "/" + this->scheFile);
+    if (!file) {
+        throw runtime_error("無法開啟" + this->dataDir + "/" + this->scheFile + "\n");
+    }
 
-        /* 創建新巴士物件 */
-        Bus* newBus = new Bus(i, hdwy); // `i` 為車輛 ID, `hdwy` 為該車的發車間距
-        fleet.push_back(newBus); // 加入車隊
+    string line, field;
+    getline(file, line); // 跳過 CSV 檔案的標題行
 
-        /* 創建事件物件 (代表該班車的發車事件) */
-        Event* newEvent = new Event( 
-            this->sche[i], // 發車時間
-            i, // 車輛 ID
-            1, // 事件類型 (1 代表發車)
-            0, // 停靠站 ID (0 代表起點站)
-            1  // 路線方向
-        );
-        eventList.push(newEvent); // 將事件加入事件列表
+    while (getline(file, line)) {
+        stringstream ss(line);
+        getline(ss, field, ',');
+        if (stoi(field) != trial) continue; // 僅讀取指定組別
+        getline(ss, field, ','); // 班次編號 (依檔案順序建立車輛)
+        getline(ss, field, ',');
+        int departure = stoi(field);
+        getline(ss, field, ',');
+        int hdwy = stoi(field);
+        this->addTrip(departure, hdwy);
+    }
+
+    if (fleet.empty()) {
+        throw runtime_error("班表檔案中沒有第 " + to_string(trial) + " 組班表");
     }
 }
 
-Bus* System::findPrevBus(Bus* target) {
+void System::readGtfs(const string& dir, const string& route, int direction, const string& service) {
+/**
+ * @brief 從 GTFS feed 讀取指定路線的實際班表，並生成車輛與事件
+ *
+ * 發車時間取各班次首站的 departure_time (frequencies.txt 定義的班次依班距展開)，
+ * 發車間距為與前一班的差值，首班車則以下一班的間距代替。
+ * 多日模擬時每日重複同一份班表。
+ *
+ * @param dir GTFS feed 目錄
+ * @param route 路線 (route_short_name 或 route_id)
+ * @param direction 方向 (direction_id)，-1 表示不篩選
+ * @param service 服務日 (service_id)，空字串表示不篩選
+ * @throws runtime_error 若無法讀取 feed 或找不到路線、班次
+ */
+    Gtfs feed(dir);
+    feed.load(route, direction, service);
+    const vector<int>& departures = feed.getDepartures();
+    if (departures.empty()) throw runtime_error("GTFS feed 中路線 " + route + " 沒有發車時間");
+
+    if (feed.getStopNames().size() != static_cast<size_t>(this->stopAmount)) {
+        out << "Warning: GTFS route " << route << " has " << feed.getStopNames().size()
+            << " stops, stops.csv has " << this->stopAmount << "\n";
+    }
+
+    fleet.reserve(departures.size() * this->days); // 預先配置車隊狀態陣列
+    for (int day = 0; day < this->days; day++) {
+        for (size_t i = 0; i < departures.size(); i++) {
+            int hdwy = i > 0 ? departures[i] - departures[i - 1]
+                     : departures.size() > 1 ? departures[1] - departures[0] : static_cast<int>(this->scheAvg.value_or(0));
+            hdwy = max(1, hdwy); // 重複的發車時刻班距為 0，至少 1 秒以免班距偏差除以 0
+            this->addTrip(departures[i] + day * 86400, hdwy);
+        }
+    }
+}
+
+void System::addTrip(int departure, int headway) {
+/**
+ * @brief 新增一個班次: 記錄發車時間，並於車隊中建立尚未發車的班次
+ *
+ * 發車事件不在此時排入事件列表，而是於模擬中依發車順序逐班排入 (見 `dispatch`)，
+ * 事件列表長度因此只與同時在路上的車輛數有關。
+ *
+ * @param departure 發車時間 (秒)
+ * @param headway 與前一班車的發車間距 (秒)
+ */
+    this->sche.push_back(departure); // 記錄發車時間
+    fleet.add(headway); // 加入車隊 (車輛 ID 依建立順序編號)
+}
+
+void System::scheduleDispatch() {
+/**
+ * @brief 將下一個尚未發車班次的發車事件排入事件列表
+ */
+    if (this->nextDispatch >= this->dispatchOrder.size()) return;
+    int id = this->dispatchOrder[this->nextDispatch++];
+
+    /* 創建事件物件 (代表該班車的發車事件) */
+    eventList.emplace(
+        this->sche[id], // 發車時間
+        id, // 車輛 ID
+        1, // 事件類型 (1 代表發車)
+        0, // 停靠站 ID (0 代表起點站)
+        1  // 路線方向
+    );
+}
+
+void System::dispatch(int bus) {
+/**
+ * @brief 班次於起點站發車: 配置車位使其成為營運中車輛，並排入下一班次的發車事件
+ *
+ * @param bus 公車編號
+ */
+    fleet.activate(bus);
+    this->scheduleDispatch();
+}
+
+int System::findPrevBus(int target) {
 /**
  * @brief 查找目標公車 (target) 在車隊中的前一輛公車
  * 
- * 這個函式會根據公車的位置 (`getLocation()`) 排序車隊 (`fleet`)，
- * 然後遍歷車隊尋找目標公車 (`target`) 前方的那輛公車。
+ * 在營運中車輛的位置 (`fleet.location`) 中找出位置大於目標公車的車輛中最靠近者，
+ * 不需排序車隊，成本只與同時在路上的車輛數有關。
+ * 禁止超車時車輛先後順序固定 (只在站點超越停靠中的車輛時調整)，直接沿先後順序查找，成本為 O(1)。
  * 
- * @param target 目標公車 (欲查找前一輛公車的對象)
- * @return Bus* 若找到前一輛公車，則回傳該公車指標；若目標公車為第一輛，則回傳 nullptr
+ * @param target 目標公車的車位編號 (欲查找前一輛公車的對象)
+ * @return int 若找到前一輛公車，則回傳該公車的車位編號；若目標公車為第一輛，則回傳 -1
+ */
+    PROFILE_SCOPE(profile, Section::FindPrevBus);
+    return this->overtaking ? fleet.leader(target) : fleet.orderedLeader(target);
+} 
+
+void System::predictiveControl(int slot, const Stop* stop, int now, double Vavg, Advice& advice) {
+/**
+ * @brief 策略二 (滾動時域預測控制): 以預測的班距偏差最小的速度與持車時間取代置站優先的建議
+ *
+ * 快照包含依目前推估位置前後最近的各 window 輛車 (位置推估與前車距離的計算相同)，
+ * 以及其中最後方車輛的下一站至預測終點 (本站之後 horizon 站) 之間的站點。
+ * 是否可能連班的判定 (績效記錄) 仍沿用置站優先的門檻。
+ *
+ * @param slot 駛離站點的車位
+ * @param stop 駛離的站點
+ * @param now 目前時間 (秒)
+ * @param Vavg 本次行駛的平均速度 (m/s)
+ * @param advice 置站優先的建議 (以預測控制的結果覆寫速度與置站時間)
  */
-    // 先依照公車位置小到大排序，確保順序正確
-    sort(this->fleet.begin(), this->fleet.end(), [](Bus* a, Bus* b) {
-        return a->getLocation() < b->getLocation();
-    });
-
-    // 遍歷車隊，找到第一輛比 `target` 位置更大的公車
-    for (auto it = fleet.begin(); it != fleet.end(); ++it) {
-        if ((*it)->getLocation() > target->getLocation()) {
-               return *it; 
+    PROFILE_SCOPE(profile, Section::Predict);
+    Horizon& model = this->horizon;
+    model.Tmax = this->getTmax();
+    model.now = now;
+    model.from = stop->id;
+    model.last = min(this->stopAmount - 1, stop->id + model.stops);
+    model.bus.clear();
+    model.bus.push_back({ stop->id + 1, 0, fleet.pax[slot], fleet.dropRate[slot], fleet.headway[slot], fleet.dwell[slot] });
+
+    /* 依推估位置挑選前後最近的車輛 (已駛離預測範圍者不影響預測) */
+    vector<tuple<double, int, double>> ahead, behind; // { 與本站的距離, 車位, 推估位置 }
+    for (int other : fleet.active) {
+        if (other == slot) continue;
+        double at = fleet.location[other] + (fleet.vol[other] ? fleet.vol[other] * (now - fleet.lastGo[other]) : 0);
+        if (at >= model.mileage[model.last]) continue;
+        if (at > stop->mileage) ahead.emplace_back(at - stop->mileage, other, at);
+        else behind.emplace_back(stop->mileage - at, other, at);
+    }
+    for (auto* side : { &ahead, &behind }) {
+        if (static_cast<int>(side->size()) > model.window) {
+            nth_element(side->begin(), side->begin() + model.window, side->end());
+            side->resize(model.window);
+        }
+        for (auto& [gap, other, at] : *side) {
+            int next = upper_bound(model.mileage.begin(), model.mileage.end(), static_cast<int>(at)) - model.mileage.begin();
+            double speed = fleet.vol[other] > 0 ? fleet.vol[other] : model.Vavg;
+            model.bus.push_back({ next, now + (model.mileage[next] - at) / speed, fleet.pax[other], fleet.dropRate[other],
+                                  fleet.headway[other], fleet.dwell[other] });
         }
     }
-    // 若沒有找到比 `target` 位置更大的公車，回傳 nullptr
-    return nullptr;
-} 
 
-double System::getArrivalRate(int time, Stop* stop) {
+    /* 站點快照 */
+    model.first = stop->id + 1;
+    for (auto& b : model.bus) model.first = min(model.first, b.next);
+    model.stop.clear();
+    for (int k = model.first; k <= model.last; k++) {
+        model.stop.push_back({ model.mileage[k], stopState.rate[k], stopState.pax[k], stopState.lastUpdate[k],
+                               static_cast<double>(this->stops[k].lastArrive) });
+    }
+
+    HorizonChoice choice = model.choose(this->Vlow.value() / 3.6, this->Vlimit.value() / 3.6, Vavg);
+    out << "Predictive control: " << choice.vol * 3.6 << " kph, hold " << choice.hold << " s (predicted deviation "
+        << choice.baseline << " -> " << choice.cost << ")\n";
+    advice.vol = choice.vol;
+    advice.dwell = fleet.dwell[slot] + choice.hold;
+    advice.leaderHold = 0;
+    advice.adjust = Advice::None;
+}
+
+int System::arrivalTime(int slot, int from, int key, int now, int dist) {
+/**
+ * @brief 計算公車抵達下一路線元素的時間，並記錄行駛中的目標
+ *
+ * 路段速度為駛離站點時決定的巡航速度 (`fleet.cruise`)；設定路段速度表時，
+ * 不超過該路段於駛離時段的背景車流速度 (查表 O(1))。
+ * 禁止超車時，前車若仍在同一路段上則以其抵達時間、已通過則以該元素上一班車的抵達時間為準，
+ * 後車不得早於該時間加最小時距抵達 (延後抵達並降低路段速度)。
+ * 前車由先後順序直接取得，每次只需 O(1)。
+ *
+ * @param slot 車位編號
+ * @param from 駛離元素的索引 (`elementKey`，即路段)
+ * @param key 下一元素的索引 (`elementKey`)
+ * @param now 駛離的時間 (秒)
+ * @param dist 至下一元素的距離 (公尺)
+ * @return int 抵達時間 (秒)
+ */
+    double speed = fleet.cruise[slot];
+    if (!this->linkSpeed.empty()) {
+        double limit = this->linkSpeed.at(from, now);
+        if (limit > 0 && limit < speed) {
+            out << "Congested link, speed limited to " << limit * 3.6 << " kph\n";
+            speed = limit;
+        }
+    }
+    fleet.vol[slot] = speed;  // 路段速度 (供前車距離推估及軌跡記錄)
+    int arrival = now + dist / speed;
+    if (!this->overtaking) {
+        int front = fleet.ahead[slot];
+        int earliest = (front >= 0 && fleet.target[front] == key) ? fleet.eta[front] : lastPass[key];
+        if (earliest >= 0 && arrival < earliest + this->minGap) {
+            out << "Following the bus ahead, arrival delayed by " << earliest + this->minGap - arrival << " seconds\n";
+            arrival = earliest + this->minGap;
+            fleet.vol[slot] = static_cast<double>(dist) / (arrival - now);  // 以實際行駛時間換算路段速度 (供前車距離推估)
+        }
+    }
+    fleet.target[slot] = key;
+    fleet.eta[slot] = arrival;
+    return arrival;
+}
+
+bool System::queuedAtLight(int slot) {
+    int front = fleet.ahead[slot];
+    return front >= 0 && fleet.target[front] < 0 && fleet.location[front] == fleet.location[slot];
+}
+
+Plan& System::signalPlan(Light* light, int time) {
+/**
+ * @brief 取得號誌在該時間適用的時制 (依星期選擇)
+ *
+ * @param light 號誌
+ * @param time 模擬時間 (秒，可跨日)
+ */
+    int day = this->dayOfWeek(time);
+    if (light->plans.size() == 7) return light->plans[day - 1];
+    if (light->plans.size() == 2) return light->plans[day <= 5 ? 0 : 1];
+    return light->plans[0];
+}
+
+int System::dayOfWeek(int time) {
+/**
+ * @brief 取得時間所屬的星期 (1 = 週一 ... 7 = 週日)，由 `general.startDay` 起算
+ *
+ * @param time 模擬時間 (秒，可跨日)
+ */
+    return (this->startDay - 1 + time / 86400) % 7 + 1;
+}
+
+int System::demandPeriod(int time) {
+/**
+ * @brief 判斷時間所屬的需求時段: 0 早尖峰、1 晚尖峰、2 離峰
+ *
+ * 尖峰時段以當日時間 (time mod 86400) 判斷，且僅在 `demand.peakDays` 所列的日子適用 (預設每天)。
+ *
+ * @param time 模擬時間 (秒，可跨日)
+ */
+    if (!this->peakDays[this->dayOfWeek(time) - 1]) return 2;
+    int timeOfDay = time % 86400;
+    if (timeOfDay >= this->morningPeak.first && timeOfDay <= this->morningPeak.second) return 0;
+    if (timeOfDay >= this->eveningPeak.first && timeOfDay <= this->eveningPeak.second) return 1;
+    return 2;
+}
+
+double System::getArrivalRate(int time, Stop* stop, KeyedRng& gen) {
 /**
  * @brief 根據時間與站點的到達率計算公車的隨機到達率
  * 
@@ -522,40 +942,31 @@ double System::getArrivalRate(int time, Stop* stop) {
  * 
  * @param time 當前時間（以秒為單位）
  * @param stop 指向 `Stop` 物件的指標，用於獲取該站點的到達率
+ * @param gen 本次到站的需求亂數產生器
  * @return double 計算出的隨機到達率，確保不小於 0
  * 
  * @note
  * - 早上尖峰 (`morningPeak`) 的到達率使用 `stop->arrivalRate[0]`
  * - 下午尖峰 (`eveningPeak`) 的到達率使用 `stop->arrivalRate[1]`
  * - 離峰時間使用 `stop->arrivalRate[2]`
- * - 使用 `std::normal_distribution` 來產生隨機變數
+ * - 結果再乘上當日的需求倍率 (`demand.dayFactor`)
+ * - 使用 `std::normal_distribution` 及以公車、站點為鍵的需求亂數產生器 (`gen`) 來產生隨機變數
  */
-    // 初始化隨機數生成器
-    random_device rd;
-    mt19937 gen(rd());
-
     double arrivalRateAvg, arrivalRateSd;
 
     // 根據當前時間選擇對應的到達率平均值與標準差
-    if (time >= this->morningPeak.first && time <= this->morningPeak.second) {
-        arrivalRateAvg = stop->arrivalRate[0].first;
-        arrivalRateSd = stop->arrivalRate[0].second;    
-    } else if (time >= this->eveningPeak.first && time <= this->eveningPeak.second) {
-        arrivalRateAvg = stop->arrivalRate[1].first;
-        arrivalRateSd = stop->arrivalRate[1].second;
-    } else {
-        arrivalRateAvg = stop->arrivalRate[2].first;
-        arrivalRateSd = stop->arrivalRate[2].second;
-    }
+    int period = this->demandPeriod(time);
+    arrivalRateAvg = stop->arrivalRate[period].first;
+    arrivalRateSd = stop->arrivalRate[period].second;
 
     // 使用常態分佈來生成隨機到達率
     normal_distribution<> dist(arrivalRateAvg, arrivalRateSd);
 
-    // 確保回傳值不小於 0
-    return max(0.0, dist(gen));
+    // 確保回傳值不小於 0，並乘上當日需求倍率
+    return max(0.0, this->sample(dist, gen)) * this->dayFactor[this->dayOfWeek(time) - 1];
 }
 
-double System::getDropRate(int time, Stop* stop) {
+double System::getDropRate(int time, Stop* stop, KeyedRng& gen) {
 /**
  * @brief 根據時間與站點的下車率計算公車的隨機下車率
  * 
@@ -566,132 +977,66 @@ double System::getDropRate(int time, Stop* stop) {
  * 
  * @param time 當前時間（以秒為單位）
  * @param stop 指向 `Stop` 物件的指標，用於獲取該站點的下車率
+ * @param gen 本次到站的需求亂數產生器
  * @return double 計算出的隨機下車率，確保不小於 0
  * 
  * @note
  * - 早上尖峰 (`morningPeak`) 的下車率使用 `stop->dropRate[0]`
  * - 早上尖峰 (`eveningPeak`) 的下車率使用 `stop->dropRate[1]`
  * - 離峰時間使用 `stop->dropRate[2]`
- * - 使用 `std::normal_distribution` 來產生隨機變數
+ * - 使用 `std::normal_distribution` 及以公車、站點為鍵的需求亂數產生器 (`gen`) 來產生隨機變數
  */
-    // 初始化隨機數生成器
-    random_device rd;
-    mt19937 gen(rd());
-
     double dropRateAvg, dropRateSd;
 
     // 根據當前時間選擇對應的下車率平均值與標準差
-    if (time >= this->morningPeak.first && time <= this->morningPeak.second) {
-        dropRateAvg = stop->dropRate[0].first;
-        dropRateSd = stop->dropRate[0].second;    
-    } else if (time >= this->eveningPeak.first && time <= this->eveningPeak.second) {
-        dropRateAvg = stop->dropRate[1].first;
-        dropRateSd = stop->dropRate[1].second;
-    } else {
-        dropRateAvg = stop->dropRate[2].first;
-        dropRateSd = stop->dropRate[2].second;
-    }
+    int period = this->demandPeriod(time);
+    dropRateAvg = stop->dropRate[period].first;
+    dropRateSd = stop->dropRate[period].second;
 
     // 使用常態分佈來生成隨機下車率
     normal_distribution<> dist(dropRateAvg, dropRateSd);
 
     // 確保回傳值不小於 0
-    return max(0.0, dist(gen));
-}
-
-Bus* System::findBus(int id) {
-/**
- * @brief 根據公車 ID 在車隊中尋找對應的公車物件
- * 
- * 此函式會遍歷 `fleet` 容器，尋找 `id` 相匹配的 `Bus` 物件，
- * 若找到則回傳該 `Bus` 指標，否則拋出 `runtime_error` 異常。
- * 
- * @param id 要查找的公車 ID
- * @return Bus* 指向對應 ID 的 `Bus` 物件指標
- * 
- * @throws runtime_error 若找不到對應 ID 的公車則拋出異常
- * 
- * @note
- * - `fleet` 是一個 `vector<Bus*>`，存放所有公車的指標
- * - 使用 `for (auto& b : this->fleet)` 來遍歷 `fleet`
- * - 若找不到符合條件的公車，則拋出錯誤訊息
- */
-    for (auto& b : this->fleet) {
-        if (b->getId() == id) {
-            return b;
-        }
-    }
-    
-    throw runtime_error("找不到 id = " + to_string(id) + " 的公車\n");
+    return max(0.0, this->sample(dist, gen));
 }
 
 Stop* System::findStop(int id) {
 /**
- * @brief 根據站點 ID 在路線中尋找對應的站點物件
+ * @brief 根據站點 ID 取得對應的站點物件
  * 
- * 此函式會遍歷 `route` 容器，嘗試尋找 `id` 相匹配的 `Stop` 物件，
- * 若找到則回傳該 `Stop` 指標，若找不到則輸出錯誤訊息並拋出異常。
+ * 站點依 ID 順序存放於 `stops` (stops[k].id == k)，直接以索引取得，不需遍歷 `route`。
  * 
  * @param id 要查找的站點 ID
  * @return Stop* 指向對應 ID 的 `Stop` 物件指標
  * 
- * @throws std::runtime_error 若找不到對應 ID 的站點則拋出異常
- * 
- * @note
- * - `route` 是一個 `vector<variant<Stop*, Light*>>`，存放 `Stop*` 或 `Light*`
- * - 使用 `find_if` 搭配 `get_if` 來判斷 `variant` 內的型別是否為 `Stop*`
+ * @throws std::runtime_error 若 ID 超出範圍則拋出異常
  */
-    // 使用 find_if 來搜尋符合條件的 Stop*
-    auto it = find_if(route.begin(), route.end(), [&](const variant<Stop*, Light*>& item) {
-        if (auto* s = get_if<Stop*>(&item)) { // 確認 item 是否為 Stop*
-            return (*s)->id == id;
-        }
-        return false;
-    });
-
-    // 如果找到符合的站點，則回傳對應的 Stop*
-    if (it != route.end()) {
-        return get<Stop*>(*it);
-    } 
-    
-    // 若找不到則拋出異常
-    throw runtime_error("找不到 ID = " + to_string(id) + " 的站點");
+    PROFILE_SCOPE(profile, Section::FindStop);
+    if (id < 0 || id >= static_cast<int>(this->stops.size())) {
+        throw runtime_error("找不到 ID = " + to_string(id) + " 的站點");
+    }
+    return &this->stops[id];
 }
 
 Light* System::findSignal(int id) {
 /**
- * @brief 根據站點 ID 在路線中尋找對應的號誌物件
+ * @brief 根據號誌 ID 取得對應的號誌物件
  * 
- * 此函式會遍歷 `route` 容器，嘗試尋找 `id` 相匹配的 `Light` 物件，
- * 若找到則回傳該 `Light` 指標，若找不到則輸出錯誤訊息並拋出異常。
+ * 號誌依 ID 順序存放於 `lights` (lights[k].id == k)，直接以索引取得，不需遍歷 `route`。
  * 
- * @param id 要查找的站點 ID
+ * @param id 要查找的號誌 ID
  * @return Light* 指向對應 ID 的 `Light` 物件指標
  * 
- * @throws std::runtime_error 若找不到對應 ID 的站點則拋出異常
- * 
- * @note
- * - `route` 是一個 `vector<variant<Stop*, Light*>>`，存放 `Stop*` 或 `Light*`
- * - 使用 `find_if` 搭配 `get_if` 來判斷 `variant` 內的型別是否為 `Light*`
+ * @throws std::runtime_error 若 ID 超出範圍則拋出異常
  */
-    // 使用 find_if 來搜尋符合條件的 Light*
-    auto it = find_if(route.begin(), route.end(), [&](const variant<Stop*, Light*>& item) {
-        if (auto* s = get_if<Light*>(&item)) { // 確認 item 是否為 Light*
-            return (*s)->id == id;
-        }
-        return false;
-    });
-
-    // 如果找到符合的站點，則回傳對應的 Light*
-    if (it != route.end()) {
-        return get<Light*>(*it);
-    } 
-    
-    // 若找不到則拋出異常
-    throw runtime_error("找不到 ID = " + to_string(id) + " 的號誌");
+    PROFILE_SCOPE(profile, Section::FindSignal);
+    if (id < 0 || id >= static_cast<int>(this->lights.size())) {
+        throw runtime_error("找不到 ID = " + to_string(id) + " 的號誌");
+    }
+    return &this->lights[id];
 }
 
-int System::handlingPax(Bus* bus, Stop* stop, int time, double dropRate) {
+int System::handlingPax(int slot, Stop* stop, int time, double dropRate) {
 /**
  * @brief 處理公車在停靠站時的乘客上下車過程
  * 
@@ -704,7 +1049,7 @@ int System::handlingPax(Bus* bus, Stop* stop, int time, double dropRate) {
  * 5. 更新公車上的乘客數量 (setPax)，並減少停靠站的需求。
  * 6. 更新公車的停留時間 (setDwell)，即根據上車乘客數量設定。
  * 
- * @param bus 當前處理的公車對象。
+ * @param slot 當前處理的公車所在車位。
  * @param stop 當前停靠的站點對象。
  * @param arrivalRate 到達率。
  * @param dropRate 下車率。
@@ -713,76 +1058,63 @@ int System::handlingPax(Bus* bus, Stop* stop, int time, double dropRate) {
 
  */
     int paxRemain, dropPax, demand, availableCapacity, boardPax, timePassed;
-    timePassed = (stop->lastArrive >=0) ? (time - stop->lastArrive) : bus->getHeadway();
-    dropPax = min(bus->getPax(), static_cast<int>(timePassed * dropRate));
-    paxRemain = bus->getPax() - dropPax;
-    demand = stop->pax;
+    timePassed = (stop->lastArrive >=0) ? (time - stop->lastArrive) : fleet.headway[slot];
+    dropPax = min(fleet.pax[slot], static_cast<int>(timePassed * dropRate));
+    paxRemain = fleet.pax[slot] - dropPax;
+    demand = static_cast<int>(stopState.pax[stop->id]);
  
-    availableCapacity = static_cast<int>(bus->getCapacity() - paxRemain);
-    cout << "availableCapacity: " << availableCapacity << "\n";
+    availableCapacity = static_cast<int>(FleetState::capacity - paxRemain);
+    out << "availableCapacity: " << availableCapacity << "\n";
 
-    cout << "Demand: " << demand << "\n";
+    out << "Demand: " << demand << "\n";
     boardPax = (demand > availableCapacity) ? availableCapacity : demand;
-    int dwellTime = static_cast<int>(boardPax * (bus->getPax() < 0.65 * bus->getCapacity() ? 2 : 2.7));
+    int dwellTime = static_cast<int>(boardPax * (fleet.pax[slot] < 0.65 * FleetState::capacity ? 2 : 2.7));
 
-    bus->setPax(paxRemain + boardPax);    
-    stop->pax -= boardPax;
-    cout << "Capacity: " << bus->getCapacity() << ", Current Passenger: " << bus->getPax() << ", Boarded Passenger: " << boardPax << endl;
+    fleet.pax[slot] = paxRemain + boardPax;    
+    stopState.pax[stop->id] -= boardPax;
+    out << "Capacity: " << FleetState::capacity << ", Current Passenger: " << fleet.pax[slot] << ", Boarded Passenger: " << boardPax << endl;
 
     return dwellTime;
 }
 
-void System::sortedFleet() {
-/**
- * @brief 根據公車的位置對車隊進行排序
- * 
- * 這個函式會根據每輛公車的地理位置 (`getLocation()`) 來對車隊 (`fleet`) 進行排序，
- * 排序的順序是從大到小，也就是說，位置較靠前的公車會排在前面。
- *
- */
-    sort(fleet.begin(), fleet.end(), [](Bus* a, Bus* b) {
-        return a->getLocation() > b->getLocation(); 
-    });
-}
-
-void System::eventPerformance(Event* e, Stop* stop, Bus* bus) {
+void System::eventPerformance(const Event& e, Stop* stop, int bus) {
 /**
  * @brief 處理公車事件的執行結果並計算與前一輛公車抵達的時間差異
  * 
- * 此函式會檢查當前公車 (bus) 相對於上一輛公車 (prevBus) 的行駛時間差，並根據這些資訊進行相應的輸出與統計。
+ * 此函式會檢查當前公車 (bus) 與上一班抵達該站的公車的時間差，並根據這些資訊進行相應的輸出與統計。
  * 它會顯示當前時間與上一輛公車的抵達時間之間的時間差，並計算偏差量。
  * 同時更新停靠站的上一輛公車抵達時間。
  * 
  * @param e 公車事件 (Event)，包含當前事件的時間與相關資料
  * @param stop 停靠站 (Stop)，儲存該站點的各項資訊，包括上一輛公車的抵達時間
- * @param bus 公車 (Bus)，需要被檢查的公車，並計算與前一輛公車的抵達時間差
+ * @param bus 公車編號，需要被檢查的公車，並計算與前一輛公車的抵達時間差
  */
-    Bus* prevBus = this->findPrevBus(bus);
-    if (prevBus) {
-        cout << "Now: "; 
-        this->printFormattedTime(e->getTime());
-        cout << ", last arrive time: ";
+    int slot = fleet.slotOf[bus];
+    if (stop->lastArrive >= 0) { // 以站點上一班車的抵達時間判斷 (前車已抵達終點站時仍須記錄班距；前車搜尋只用於控制)
+        out << "Now: "; 
+        this->printFormattedTime(e.getTime());
+        out << ", last arrive time: ";
         this->printFormattedTime(stop->lastArrive); 
-        cout << ", scheduled headeay: " << bus->getHeadway() / 60 << " min\n";
+        out << ", scheduled headeay: " << fleet.headway[slot] / 60 << " min\n";
         
-        cout << "headway deviation: " << abs(static_cast<float>((e->getTime() - stop->lastArrive) - bus->getHeadway())) << " seconds\n";
-        this->incrHeadwayDev(pow(static_cast<float>((e->getTime() - stop->lastArrive) - bus->getHeadway()) / static_cast<float>(bus->getHeadway()), 2)); //headway deviation
-        cout << "Cumulative headway deviation: " << this->headwayDev << "\n";
+        out << "headway deviation: " << abs(static_cast<float>((e.getTime() - stop->lastArrive) - fleet.headway[slot])) << " seconds\n";
+        this->incrHeadwayDev(pow(static_cast<float>((e.getTime() - stop->lastArrive) - fleet.headway[slot]) / static_cast<float>(fleet.headway[slot]), 2)); //headway deviation
+        this->metrics.recordHeadway(stop->id, bus, e.getTime() - stop->lastArrive, fleet.headway[slot]); // 記錄實際與表定班距
+        out << "Cumulative headway deviation: " << this->headwayDev << "\n";
     }
-    stop->lastArrive = e->getTime();
+    stop->lastArrive = e.getTime();
 }
 
-void System::arriveAtStop(Event* e) {
+void System::arriveAtStop(const Event& e) {
 /**
  * @brief 處理公車到達站點的事件，並更新相關的車輛與站點狀態
  *
  * 當公車抵達一個站點時，這個函式會：
  * 1. 顯示事件的詳細資訊。
  * 2. 根據事件獲得相關的公車與站點物件。
- * 3. 計算並更新公車與站點的狀態。
- * 4. 處理乘客的上下車。
- * 5. 根據上下車處理的結果更新站點與車輛的績效。
- * 6. 設定並推送下一個事件。
+ * 3. 更新公車的位置與速度。
+ * 4. 若站點的停靠席位有限且已滿，加入排隊等候 (待前方車輛離開後以事件 6 進入席位)。
+ * 5. 否則直接進入席位處理上下客 (`serveAtStop`)。
  *
  * @param e 當前的事件物件，代表公車到達某站點
  */
@@ -790,57 +1122,133 @@ void System::arriveAtStop(Event* e) {
     this->printEventDetails(e);  // 顯示事件的詳細資訊 (例如時間、車輛、站點等)
 
     /* 取得事件元素 */
-    Bus* bus = this->findBus(e->getBusID());  // 根據事件中的車輛 ID 取得對應的公車物件
-    Stop* stop = this->findStop(e->getStopID());  // 根據事件中的站點 ID 取得對應的站點物件
-
-    /* 取得當前當站的到達率及下車率 */
-    double arrivalRate, dropRate;
-    // 若站點 ID 不為 0，則使用公車的到達率與下車率；若為 0，則使用依據上個離站事件時間計算的到達率與下車率
-    arrivalRate = stop->id ? bus->getArrivalRate() : this->getArrivalRate(e->getTime(), stop);
-    dropRate = stop->id ? bus->getDropRate() : this->getDropRate(e->getTime(), stop);
+    int bus = e.getBusID();  // 事件中的車輛 ID (班次)
+    Stop* stop = this->findStop(e.getStopID());  // 根據事件中的站點 ID 取得對應的站點物件
+    if (stop->id == 0) this->dispatch(bus);  // 起點站發車: 配置車位並排入下一班次的發車事件
+    int slot = fleet.slotOf[bus];  // 車輛狀態所在的車位
 
     /* 更新公車狀態 */
-    bus->setVol(0);  // 設定車輛速度為 0，代表公車在站點停等
-    bus->setLocation(stop->mileage);  // 更新公車的位置為當前站點的里程
-    this->sortedFleet();  // 重新排序車隊，確保車輛狀態正確
+    fleet.vol[slot] = 0;  // 設定車輛速度為 0，代表公車在站點停等
+    fleet.location[slot] = stop->mileage;  // 更新公車的位置為當前站點的里程
+    fleet.target[slot] = -1;  // 停靠於站點
+    lastPass[this->elementKey(stop)] = e.getTime();
+    if (stop->id == 0) this->metrics.recordDispatch(bus, e.getTime());  // 記錄發車時間
+
+    /* 停靠席位有限時加入佇列；席位已滿則等候 */
+    BerthQueue& queue = stopState.berth[stop->id];
+    if (queue.berths > 0) {
+        if (queue.full()) {  // 到站率長期高於席位的服務率時佇列會無限增長，視為設定錯誤
+            throw runtime_error("站點 " + stop->stopName + " 停靠與等候的車輛超過 " + to_string(BerthQueue::capacity) + " 輛，請增加停靠席位或班距");
+        }
+        queue.push(bus, e.getTime());
+        if (queue.size > queue.berths) {
+            out << "All " << static_cast<int>(queue.berths) << " berths are occupied, waiting in queue (position " << queue.size - queue.berths << ")\n\n";
+            return;
+        }
+    }
 
-    /* 更新站點狀態 */
+    this->serveAtStop(e, stop, bus, slot);
+}
+
+void System::enterBerth(const Event& e) {
+/**
+ * @brief 處理排隊中的公車進入停靠席位的事件 (前方車輛離站後產生)
+ *
+ * @param e 當前的事件物件 (事件種類 6)
+ */
+    this->printEventDetails(e);
+
+    int bus = e.getBusID();
+    Stop* stop = this->findStop(e.getStopID());
+    BerthQueue& queue = stopState.berth[stop->id];
+    this->metrics.recordBerthWait(e.getTime() - queue.arrivalOf(bus));  // 依公車編號取得到站時間 (同一時刻可能有其他車輛離站，本車不一定在最後一個席位)
+
+    this->serveAtStop(e, stop, bus, fleet.slotOf[bus]);
+}
+
+void System::serveAtStop(const Event& e, Stop* stop, int bus, int slot) {
+/**
+ * @brief 公車進入停靠席位後處理上下客、計算績效並排入離站事件
+ *
+ * @param e 當前的事件物件 (到站或進入席位)
+ * @param stop 站點
+ * @param bus 公車編號
+ * @param slot 車位編號
+ */
+    /* 取得當前當站的下車率 (保存至公車，供離站時估計下一站的上車人數) */
+    KeyedRng demand(this->demandSeed, bus, stop->id);  // 同一班次在同一站的需求抽樣與事件處理順序無關
+    double dropRate = this->getDropRate(e.getTime(), stop, demand);
+    fleet.dropRate[slot] = dropRate;
+
+    /* 更新站點狀態: 累積至今的候車乘客，並抽樣至下一班車到站為止的到達率 */
+    double arrivalRate = this->getArrivalRate(e.getTime(), stop, demand);
     if (stop->lastArrive >= 0) {  // 若站點有上一班車的到達時間
-        stop->pax += static_cast<int>((e->getTime() - stop->lastArrive) * arrivalRate);  // 根據事件時間差與到達率計算新增乘客數
+        stopState.accrue(stop->id, e.getTime());  // 以上一班車到站時抽樣的到達率累積 (定期累積已加入的部分不重複計算)
     } else {  // 若站點沒有上一班車的到達時間
-        stop->pax += bus->getHeadway() * arrivalRate;  // 根據發車間距與到達率計算新增乘客數
+        stopState.pax[stop->id] += fleet.headway[slot] * arrivalRate;  // 根據發車間距與到達率計算新增乘客數
+        stopState.lastUpdate[stop->id] = e.getTime();
     }
+    stopState.rate[stop->id] = arrivalRate;
 
     /* 處理乘客上下車 */
-    cout << "Processing Passengers alighting and boarding...\n";
-    int dwellTime = this->handlingPax(bus, stop, e->getTime(), dropRate);  // 處理上下車，並返回停留時間 (dwellTime)
+    out << "Processing Passengers alighting and boarding...\n";
+    int dwellTime = this->handlingPax(slot, stop, e.getTime(), dropRate);  // 處理上下車，並返回停留時間 (dwellTime)
+    this->metrics.recordDwell(stop->id, dwellTime);  // 記錄置站時間分佈
 
     /* 計算績效值 */
     this->eventPerformance(e, stop, bus);  // 計算並更新績效指標
 
     /* 建立新事件 */
-    auto itor = route.find(stop);  // 找到當前站點在路線中的位置
-    if (itor != route.end() && itor == prev(route.end())) {  // 若為終點站
-        cout << "Arrive at terminal\n\n";  // 顯示已經抵達終點站
+    if (stop->id == this->stopAmount - 1) {  // 若為終點站 (路線最後一站；其後可能仍有號誌)
+        out << "Arrive at terminal\n\n";  // 顯示已經抵達終點站
+        this->metrics.recordTrip(bus, stop->id, e.getTime(), stop->mileage);  // 記錄營運速度並結束連班事件
+        fleet.retire(bus);  // 退出營運並歸還車位，不再作為後車的前車
         return;   // 結束當前事件，無需再建立新事件
     } else {
-        cout << "Continue to next stop...\n";
+        out << "Continue to next stop...\n";
         // 創建新的事件，表示從當前站點出發
-        Event* newEvent = new Event(
-            e->getTime() + min(this->getTmax(), max(bus->getDwell(), dwellTime)),  // 新事件的時間為當前時間 + 停留時間
-            bus->getId(),  // 車輛 ID
+        eventList.emplace(
+            e.getTime() + min(this->getTmax(), max(fleet.dwell[slot], dwellTime)),  // 新事件的時間為當前時間 + 停留時間
+            bus,  // 車輛 ID
             2,  // 事件類型為 2 (離站)
-            e->getStopID(),  // 當前站點 ID
-            e->getDirection()  // 當前方向
+            e.getStopID(),  // 當前站點 ID
+            e.getDirection()  // 當前方向
         );
-        eventList.push(newEvent);  // 將新事件推送到事件列表
     }
 
-    bus->setDwell(bus->getDwell() - min(this->getTmax(), bus->getDwell()));  // 更新公車的停留時間，考慮最大允許停留時間 (Tmax)
-    cout << "\n";  // 換行顯示
+    fleet.dwell[slot] = fleet.dwell[slot] - min(this->getTmax(), fleet.dwell[slot]);  // 更新公車的停留時間，考慮最大允許停留時間 (Tmax)
+    out << "\n";  // 換行顯示
 }
 
-void System::deptFromStop(Event* e) {
+bool System::leaveBerth(const Event& e) {
+/**
+ * @brief 公車欲離開有席位限制的站點: 前方仍有車輛時須等候，離開後讓後方車輛跟進
+ *
+ * 前方車輛離開時，已完成上下客的下一輛車於同一時刻離開 (事件 2)，
+ * 排隊中的第一輛車則進入空出的席位 (事件 6)。
+ *
+ * @param e 離站事件
+ * @return bool 是否可以離開 (false 表示被前方車輛阻擋，稍後再產生離站事件)
+ */
+    int bus = e.getBusID();
+    BerthQueue& queue = stopState.berth[e.getStopID()];
+    if (queue.front() != bus) {
+        queue.markReady(bus);
+        out << "Blocked by bus " << queue.front() << " in front of the berth\n\n";
+        return false;
+    }
+
+    queue.pop();
+    if (queue.size > 0 && queue.ready[queue.head]) {  // 下一輛車已完成上下客，隨之離開
+        eventList.emplace(e.getTime(), queue.front(), 2, e.getStopID(), e.getDirection());
+    }
+    if (queue.size >= queue.berths) {  // 排隊中的車輛進入空出的席位
+        eventList.emplace(e.getTime(), queue.bus[queue.at(queue.berths - 1)], 6, e.getStopID(), e.getDirection());
+    }
+    return true;
+}
+
+void System::deptFromStop(const Event& e) {
 /**
  * @brief 處理公車離開站點的事件，並更新相關的車輛與站點狀態
  *
@@ -859,95 +1267,80 @@ void System::deptFromStop(Event* e) {
     this->printEventDetails(e);  // 顯示事件的詳細資訊 (例如時間、車輛、站點等)
 
     /* 取得事件所需之元素 */
-    auto bus = this->findBus(e->getBusID());  // 根據事件中的車輛 ID 查找對應的公車物件
-    auto stop = this->findStop(e->getStopID());  // 根據事件中的站點 ID 查找對應的站點物件
-
-    /* 取得當前當站的到達率及下車率 */
-    auto arrivalRate = bus->getArrivalRate();  // 取得公車的到達率
-    bus->setArrivalRate(arrivalRate);  // 更新公車的到達率
-    auto dropRate = bus->getDropRate();  // 取得公車的下車率
-    bus->setDropRate(dropRate);  // 更新公車的下車率
-
-    /* 取得平均速度分佈與上下限 */
-    random_device rd;
-    mt19937 gen(rd());
+    int bus = e.getBusID();  // 事件中的車輛 ID (班次)
+    int slot = fleet.slotOf[bus];  // 車輛狀態所在的車位
+    auto stop = this->findStop(e.getStopID());  // 根據事件中的站點 ID 查找對應的站點物件
+    if (stopState.berth[stop->id].berths > 0 && !this->leaveBerth(e)) return;  // 席位有限時依序離開
+    if (!this->overtaking) fleet.overtake(slot);  // 站點允許越過停靠中的前車
+
+    /* 取得當站的下車率 (到站時抽樣) */
+    auto dropRate = fleet.dropRate[slot];
+
+    /* 取得平均速度分佈 (上下限由 getAdvisor 套用) */
     normal_distribution<> dist(this->Vavg.value(), this->Vsd.value());
-    double Vavg = max(0.0, dist(gen)) / 3.6;  // 計算公車行駛的平均速度 (單位：m/s)
-    double Vlimit = this->Vlimit.value() / 3.6;  // 設定行駛速度的上限 (單位：m/s)
-    double Vlow = this->Vlow.value() / 3.6;  // 設定行駛速度的下限 (單位：m/s)
+    KeyedRng speed(this->speedSeed, bus, stop->id);
+    double Vavg = max(this->Vlow.value(), this->sample(dist, speed)) / 3.6;  // 計算公車行駛的平均速度 (單位：m/s)，不低於速度下限以免行駛時間發散
 
     /* 更新公車狀態 */
-    bus->setLastGo(e->getTime());  // 設定公車的最後離站時間為當前事件的時間
+    fleet.lastGo[slot] = e.getTime();  // 設定公車的最後離站時間為當前事件的時間
+    this->metrics.recordLoad(stop->id, bus, fleet.pax[slot], FleetState::capacity);  // 記錄離站載客率
 
     /* 計算行駛速度(策略一：置站優先) */
     auto nextStop = this->getNextStop(stop->id);  // 取得當前站點的下一站
     if (nextStop.has_value()) {
-        cout << "Next stop is: " << nextStop.value()->id << " " << nextStop.value()->stopName << "\n";
+        out << "Next stop is: " << nextStop.value()->id << " " << nextStop.value()->stopName << "\n";
 
         // 計算上車的乘客數量
-        int boardPax = min(nextStop.value()->pax + static_cast<int>(ceil(bus->getHeadway()*arrivalRate)), 
-                           static_cast<int>(bus->getCapacity() - (bus->getPax() * dropRate))); // 上車乘客數量
-        int paxTime = static_cast<int>(boardPax * (bus->getPax() < 0.65 * bus->getCapacity() ? 2 : 2.7));  // 計算上下車的時間
-        int totaldwell = paxTime + bus->getDwell();  // 計算總停留時間
-        cout << "total dwell time = " << totaldwell << "\n";
+        int next = nextStop.value()->id;
+        stopState.accrue(next, e.getTime());  // 先累積至今，使估計值與是否定期累積無關
+        int boardPax = min(static_cast<int>(stopState.pax[next]) + static_cast<int>(ceil(fleet.headway[slot] * stopState.rate[next])), 
+                           static_cast<int>(FleetState::capacity - (fleet.pax[slot] * dropRate))); // 上車乘客數量
+        int paxTime = static_cast<int>(boardPax * (fleet.pax[slot] < 0.65 * FleetState::capacity ? 2 : 2.7));  // 計算上下車的時間
+        int totaldwell = paxTime + fleet.dwell[slot];  // 計算總停留時間
+        out << "total dwell time = " << totaldwell << "\n";
+
+        // 取得前車距離 (第一班車無前車)
+        int prevSlot = this->findPrevBus(slot);  // 找出前一班車
+        optional<double> distance;
+        if (prevSlot >= 0 && fleet.vol[prevSlot]) {
+            distance = fleet.location[prevSlot] + fleet.vol[prevSlot] * (e.getTime() - fleet.lastGo[prevSlot]) - stop->mileage;
+        } else if (prevSlot >= 0) {
+            distance = fleet.location[prevSlot] - stop->mileage;
+        }
 
         // 設定公車的行駛速度與停留時間
-        Bus* prevBus = this->findPrevBus(bus);  // 找出前一班車
-        if (!prevBus) {  // 第一班車
-            cout << "The first bus should not follow other's velocity" << "\n";
-            bus->setVol(Vavg);  // 設定速度為平均速度
-            bus->setDwell(totaldwell);  // 設定停留時間
-            cout << "vol = " << bus->getVol() * 3.6 << " kph, dwell time = " << bus->getDwell() << "\n";
+        Advice advice = this->getAdvisor().advise(Vavg, fleet.headway[slot], totaldwell, distance);
+        if (this->scheme == 2 && distance) this->predictiveControl(slot, stop, e.getTime(), Vavg, advice);
+        if (!distance) {
+            out << "The first bus should not follow other's velocity" << "\n";
+        } else if (!advice.bunching) {
+            if (fleet.bunching[slot].second) out << "recovered the bunching problem successfully in " << stop->id - fleet.bunching[slot].first << "stops.\n";
+            fleet.bunching[slot] = make_pair(stop->id, 0);
+            this->metrics.recordBunching(bus, stop->id, e.getTime(), false);
+            out << "No bunching, just run with avg speed.\n";
         } else {
-            double distance, newVol;
-            // 取得前車距離
-            if (prevBus->getVol()) {
-                distance = prevBus->getLocation() + prevBus->getVol() * (e->getTime() - prevBus->getLastGo()) - stop->mileage;
-                newVol = distance / (bus->getHeadway() + totaldwell);  // 計算新速度
-            } else {
-                distance = prevBus->getLocation() - stop->mileage;
-                newVol = distance / (bus->getHeadway() + totaldwell);  // 計算新速度
-            }
-        
-            // 如果公車的行駛速度過慢，則恢復到平均速度
-            if ((distance / Vavg) < bus->getHeadway() * this->schemeThreshold.value()) {
-                newVol = Vavg;
-                if (bus->bunching.second) cout << "recovered the bunching problem successfully in " << stop->id - bus->bunching.first << "stops.\n";
-                bus->bunching = make_pair(stop->id, 0);
-                cout << "No bunching, just run with avg speed.\n";
-            } else {
-                bus->bunching = make_pair(stop->id, 1);  // 設定為可能發生連班
-                cout << "There's might be bus bunching, use the given scheme\n";
-            }
-            
-            // 如果速度太低，進行調整
-            if(newVol < Vlow) {
-                cout << "Yes it's too close\n";
-                cout << "distance: " << distance << "\n";
-                cout << "paxTime: " << paxTime << "\n";
-                cout << "totalDwell: " << totaldwell << "\n";
-                totaldwell += (distance / newVol) - (distance / Vavg);  // 調整總停留時間
-                newVol = Vavg;  // 恢復到平均速度
-                bus->setVol(newVol);
-                bus->setDwell(totaldwell);
-            } else if (newVol > Vlimit) {  // 如果速度過快，則限制速度
-                cout << "Yes it's too far\n";
-                cout << "distance: " << distance << "\n";
-                cout << "paxTime: " << paxTime << "\n";
-                cout << "totalDwell: " << totaldwell << "\n";
-                cout << "hdwy: " << bus->getHeadway() << "\n";
-                prevBus->setDwell(prevBus->getDwell() + (distance / Vlimit) - (distance / newVol));  // 調整前一班車的停留時間
-                newVol = Vlimit;  // 限制速度為上限
-            }
-
-            bus->setVol(newVol);  // 設定新速度
-            bus->setDwell(totaldwell);  // 設定新停留時間
-            cout << "distance = " << distance << " new Vol = " << newVol * 3.6 << " kph\n";
-        } 
+            fleet.bunching[slot] = make_pair(stop->id, 1);  // 設定為可能發生連班
+            this->metrics.recordBunching(bus, stop->id, e.getTime(), true);
+            out << "There's might be bus bunching, use the given scheme\n";
+        }
+        if (advice.adjust != Advice::None) {
+            out << (advice.adjust == Advice::TooClose ? "Yes it's too close\n" : "Yes it's too far\n");
+            out << "distance: " << *distance << "\n";
+            out << "paxTime: " << paxTime << "\n";
+            out << "totalDwell: " << totaldwell << "\n";
+        }
+        if (advice.adjust == Advice::TooFar) {
+            fleet.dwell[prevSlot] = fleet.dwell[prevSlot] + advice.leaderHold;  // 調整前一班車的停留時間
+        }
+        fleet.vol[slot] = advice.vol;  // 設定新速度
+        fleet.dwell[slot] = advice.dwell;  // 設定新停留時間
+        if (distance) out << "distance = " << *distance << " new Vol = " << advice.vol * 3.6 << " kph\n";
+        else out << "vol = " << fleet.vol[slot] * 3.6 << " kph, dwell time = " << fleet.dwell[slot] << "\n";
     }
 
     /* 產生新事件 */
     if (stop->id == this->stopAmount - 1) return;  // 如果是終點站，結束事件
+    fleet.cruise[slot] = fleet.vol[slot];  // 之後各路段以此為速度上限
     auto nextElement = findNext(stop);  // 找到下一個元素 (站點或號誌)
     if(nextElement.has_value()) {
         // 訪問並建立新事件
@@ -956,37 +1349,35 @@ void System::deptFromStop(Event* e) {
             if constexpr (is_same_v<T, Stop>) {
                 // 如果是站點，計算並建立到達該站點的事件
                 int dist =  obj->mileage - stop->mileage;
-                int newTime = e->getTime() + dist / bus->getVol();
-                Event* newEvent = new Event( //arrive at stop
+                int newTime = this->arrivalTime(slot, this->elementKey(stop), this->elementKey(obj), e.getTime(), dist);
+                eventList.emplace( //arrive at stop
                     newTime, 
-                    bus->getId(),
+                    bus,
                     1, 
                     obj->id, 
-                    e->getDirection()
+                    e.getDirection()
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
             } else if constexpr (is_same_v<T, Light>) {
                 // 如果是號誌，計算並建立到達該號誌的事件
-                cout << "Next Light ID: " << obj->id << endl;
+                out << "Next Light ID: " << obj->id << endl;
                 int dist = obj->mileage - stop->mileage;
-                int newTime = e->getTime() + dist / bus->getVol();
-                Event* newEvent = new Event( //arrive at light
+                int newTime = this->arrivalTime(slot, this->elementKey(stop), this->elementKey(obj), e.getTime(), dist);
+                eventList.emplace( //arrive at light
                     newTime, 
-                    bus->getId(),
+                    bus,
                     3, 
                     obj->id, 
-                    e->getDirection()
+                    e.getDirection()
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
             }
         }, nextElement.value());
     } else {
         throw runtime_error("找不到路線中下一個元素");  // 如果找不到下一個元素，拋出異常
     }
-    cout << "\n";  // 換行顯示
+    out << "\n";  // 換行顯示
 }
 
-void System::arriveAtLight(Event* e) {
+void System::arriveAtLight(const Event& e) {
 /**
  * @brief 處理公車到達號誌的事件，並根據號誌顯示紅綠燈狀態，更新公車狀態。
  *
@@ -994,7 +1385,8 @@ void System::arriveAtLight(Event* e) {
  * 1. 顯示事件的詳細資訊。
  * 2. 根據事件獲得相關的公車與號誌物件。
  * 3. 更新公車的行駛狀態，包括位置與速度。
- * 4. 計算當前號誌的燈號，如果為綠燈則公車繼續行駛，若為紅燈則等待。
+ * 4. 計算當前號誌的燈號，如果為綠燈則公車繼續行駛，若為紅燈則等待；
+ *    設定一般車流量時，另須等排在前方的停等車輛於綠燈開始後紓解 (`SignalQueue`)。
  * 5. 根據燈號設定新事件，抵達下一元素或離開號誌。
  *
  * @param e 當前的事件物件，代表公車到達號誌
@@ -1003,32 +1395,44 @@ void System::arriveAtLight(Event* e) {
     this->printEventDetails(e);  // 顯示事件的詳細資訊 (例如時間、車輛、號誌等)
 
     /* 取得事件所需之元素 */
-    auto bus = this->findBus(e->getBusID());  // 根據事件中的車輛 ID 查找對應的公車物件
-    auto light = this->findSignal(e->getLightID());  // 根據事件中的號誌 ID 查找對應的號誌物件
+    int bus = e.getBusID();  // 事件中的車輛 ID (班次)
+    int slot = fleet.slotOf[bus];  // 車輛狀態所在的車位
+    auto light = this->findSignal(e.getLightID());  // 根據事件中的號誌 ID 查找對應的號誌物件
 
     /* 更新公車狀態 */
-    bus->setLocation(light->mileage);  // 設定公車的當前位置為號誌的位置
-    bus->setNextVol(bus->getVol());  // 保存公車的當前速度
-    bus->setVol(0.0);  // 設定公車的行駛速度為 0
+    fleet.location[slot] = light->mileage;  // 設定公車的當前位置為號誌的位置
+    fleet.nextVol[slot] = fleet.vol[slot];  // 保存公車的當前速度
+    fleet.vol[slot] = 0.0;  // 設定公車的行駛速度為 0
+    fleet.target[slot] = -1;  // 停等於號誌
+    lastPass[this->elementKey(light)] = e.getTime();
 
     /* 計算號誌燈號 */
-    int timeRemain = light->plan.calculateSignal(e->getTime());  // 根據事件時間計算剩餘的紅綠燈時間
+    int timeRemain;
+    auto& queue = this->signalQueue[light->id];
+    if (queue.enabled()) {  // 一般車流停等: 等前方車輛紓解後才能通過 (綠燈且無停等車輛時為 0)
+        timeRemain = queue.departure(e.getTime(), [&](int t) { return this->signalPlan(light, t).greenWindow(t); }) - e.getTime();
+    } else {
+        timeRemain = this->signalPlan(light, e.getTime()).calculateSignal(e.getTime());  // 根據事件時間與當日時制計算剩餘的紅綠燈時間
+    }
 
     /* 根據燈號進行處理 */
-    if (timeRemain == 0) {  // 若燈號為綠燈
-        cout << "Now is GREEN, just go through...\n";
-        bus->setVol(bus->getNextVol());  // 恢復公車的行駛速度
+    if (timeRemain == 0 && !this->overtaking && this->queuedAtLight(slot)) {  // 綠燈但前車仍在路口停等: 依序於前車之後通過
+        out << "Now is GREEN, but the bus ahead has not left yet...\n\n";
+        eventList.emplace(e.getTime() + this->minGap, bus, 4, light->id, e.getDirection());
+        return;
+    } else if (timeRemain == 0) {  // 若燈號為綠燈
+        out << "Now is GREEN, just go through...\n";
+        fleet.vol[slot] = fleet.nextVol[slot];  // 恢復公車的行駛速度
     } else {  // 若燈號為紅燈
-        cout << "Now is RED, wait for " << timeRemain <<" seconds...\n\n";
+        out << (queue.enabled() ? "Queued at the light, wait for " : "Now is RED, wait for ") << timeRemain <<" seconds...\n\n";
         // 創建新的事件表示等待紅燈
-        Event* newEvent = new Event( // 從號誌出發
-            e->getTime() + timeRemain,  // 設定新的事件時間為當前時間加上等待時間
-            bus->getId(),  // 使用當前公車的 ID
+        eventList.emplace( // 從號誌出發
+            e.getTime() + timeRemain,  // 設定新的事件時間為當前時間加上等待時間
+            bus,  // 使用當前公車的 ID
             4,  // 事件類型為 4，表示離開號誌
             light->id,  // 號誌的 ID
-            e->getDirection()  // 設定公車的行駛方向
+            e.getDirection()  // 設定公車的行駛方向
         );
-        eventList.push(newEvent);  // 將新的事件加入事件列表
         return;  
     }
 
@@ -1039,40 +1443,38 @@ void System::arriveAtLight(Event* e) {
         visit([&](auto* obj) {
             using T = decay_t<decltype(*obj)>;
             if constexpr (is_same_v<T, Stop>) {  // 如果是站點
-                cout << "Next Stop ID: " << obj->id << endl;
+                out << "Next Stop ID: " << obj->id << endl;
                 int dist =  obj->mileage - light->mileage;  // 計算從號誌到站點的距離
-                int newTime = e->getTime() + dist / bus->getVol();  // 計算到達該站點的時間
-                Event* newEvent = new Event( // 到達站點事件
+                int newTime = this->arrivalTime(slot, this->elementKey(light), this->elementKey(obj), e.getTime(), dist);  // 計算到達該站點的時間
+                eventList.emplace( // 到達站點事件
                     newTime, 
-                    bus->getId(),
+                    bus,
                     1,  // 事件類型為 1，表示到達站點
                     obj->id, 
-                    e->getDirection()
+                    e.getDirection()
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
 
             } else if constexpr (is_same_v<T, Light>) {  // 如果是號誌
-                cout << "Next Light ID: " << obj->id << endl;
+                out << "Next Light ID: " << obj->id << endl;
                 int dist = obj->mileage - light->mileage;  // 計算從當前號誌到下一號誌的距離
-                int newTime = e->getTime() + dist / bus->getVol();  // 計算到達下一號誌的時間
-                Event* newEvent = new Event( // 到達號誌事件
+                int newTime = this->arrivalTime(slot, this->elementKey(light), this->elementKey(obj), e.getTime(), dist);  // 計算到達下一號誌的時間
+                eventList.emplace( // 到達號誌事件
                     newTime, 
-                    bus->getId(),
+                    bus,
                     3,  // 事件類型為 3，表示到達號誌
                     obj->id, 
-                    e->getDirection()
+                    e.getDirection()
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
             }
         }, nextElement.value());  // 處理下一元素
     } else {
-        cout << "Can't find next element or no next\n";  // 如果找不到下一個元素或沒有下一元素
+        out << "Can't find next element or no next\n";  // 如果找不到下一個元素或沒有下一元素
     }
     
-    cout << "\n";  // 換行顯示
+    out << "\n";  // 換行顯示
 }
 
-void System::deptFromLight(Event* e) {
+void System::deptFromLight(const Event& e) {
 /**
  * @brief 處理公車離開號誌的事件，並根據號誌燈的位置與公車的速度計算到達下一個目的地的時間。
  * 
@@ -1088,13 +1490,21 @@ void System::deptFromLight(Event* e) {
     this->printEventDetails(e); 
 
     /* 取得事件所需的物件 */
-    auto bus = this->findBus(e->getBusID());  // 根據事件中的車輛 ID 查找對應的公車物件
-    auto light = this->findSignal(e->getLightID());  // 根據事件中的號誌燈 ID 查找對應的號誌燈物件
+    int bus = e.getBusID();  // 事件中的車輛 ID (班次)
+    int slot = fleet.slotOf[bus];  // 車輛狀態所在的車位
+    auto light = this->findSignal(e.getLightID());  // 根據事件中的號誌燈 ID 查找對應的號誌燈物件
+
+    /* 禁止超車時，前車尚未離開路口則依最小時距延後 */
+    if (!this->overtaking && this->queuedAtLight(slot)) {
+        out << "Waiting for the bus ahead to leave the intersection\n\n";
+        eventList.emplace(e.getTime() + this->minGap, bus, 4, light->id, e.getDirection());
+        return;
+    }
 
     /* 更新公車狀態 */
-    bus->setLocation(light->mileage);  // 設定公車的位置為號誌燈的位置
-    bus->setVol(bus->getNextVol());  // 設定公車的速度為上次設定的速度
-    bus->setLastGo(e->getTime());  // 設定公車的最近一次出發時間為當前事件的時間
+    fleet.location[slot] = light->mileage;  // 設定公車的位置為號誌燈的位置
+    fleet.vol[slot] = fleet.nextVol[slot];  // 設定公車的速度為上次設定的速度
+    fleet.lastGo[slot] = e.getTime();  // 設定公車的最近一次出發時間為當前事件的時間
 
     /* 產生新事件 */
     auto nextElement = findNext(light);  // 查找號誌燈後的下一個元素（可能是站點或號誌燈）
@@ -1105,64 +1515,410 @@ void System::deptFromLight(Event* e) {
             // 如果下一個元素是站點
             if constexpr (is_same_v<T, Stop>) {
                 int dist = obj->mileage - light->mileage;  // 計算從號誌燈到下一站的距離
-                int newTime = e->getTime() + dist / bus->getVol();  // 計算到達下一站的時間
-                Event* newEvent = new Event(  // 創建一個新的到站事件
+                int newTime = this->arrivalTime(slot, this->elementKey(light), this->elementKey(obj), e.getTime(), dist);  // 計算到達下一站的時間
+                eventList.emplace( // 創建一個新的到站事件
                     newTime, 
-                    bus->getId(),
+                    bus,
                     1,  // 事件類型為「到站」
                     obj->id,  // 站點 ID
-                    e->getDirection()  // 方向
+                    e.getDirection()  // 方向
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
 
             // 如果下一個元素是號誌燈
             } else if constexpr (is_same_v<T, Light>) {
-                cout << "Next Light ID: " << obj->id << endl;  // 顯示下一個號誌燈的 ID
+                out << "Next Light ID: " << obj->id << endl;  // 顯示下一個號誌燈的 ID
                 int dist = obj->mileage - light->mileage;  // 計算從當前號誌燈到下一號誌燈的距離
-                int newTime = e->getTime() + dist / bus->getVol();  // 計算到達下一號誌燈的時間
-                Event* newEvent = new Event(  // 創建一個新的到號誌燈事件
+                int newTime = this->arrivalTime(slot, this->elementKey(light), this->elementKey(obj), e.getTime(), dist);  // 計算到達下一號誌燈的時間
+                eventList.emplace( // 創建一個新的到號誌燈事件
                     newTime, 
-                    bus->getId(),
+                    bus,
                     3,  // 事件類型為「到達號誌」
                     obj->id,  // 號誌燈 ID
-                    e->getDirection()  // 方向
+                    e.getDirection()  // 方向
                 );
-                eventList.push(newEvent);  // 將新事件加入事件列表
             }
         }, nextElement.value());  // 呼叫訪問函式並處理下一個元素
     } else {
-        cout << "Can't find next element or no next\n";  // 如果找不到下一個元素，顯示錯誤訊息
+        out << "Can't find next element or no next\n";  // 如果找不到下一個元素，顯示錯誤訊息
     }
-    cout << "\n";  // 換行
+    out << "\n";  // 換行
 }  
 
 void System::simulation() {
 /**
  * @brief 模擬系統事件處理流程
  * 
- * 這個函式會不斷從事件列表 (`eventList`) 取出最高優先級的事件，並根據事件類型執行相對應的處理函式。
- * 當事件處理完後，該事件會從 `eventList` 移除，直到 `eventList` 為空，模擬才會結束。
+ * 這個函式會不斷從事件列表 (`eventList`) 取出最高優先級的事件，並根據事件類型執行相對應的處理函式，直到 `eventList` 為空，模擬才會結束。
+ * 事件在處理前即自 `eventList` 移除: 處理函式可能推入同一時刻、優先順序更高的新事件，
+ * 若處理後才移除，移除的會是新事件，而剛處理完的事件會再被處理一次。
  * 
  * @throws std::runtime_error 如果遇到未知的事件類型，則拋出異常。
  */
+    bool recording = !this->trajectoryPath.empty();
+    if (recording) {
+        trajectory.reserve(fleet.size(), 2 * route.size() + 2); // 每車每個路線元素約有到達、離開兩筆記錄
+    }
+
+    profile.setTracing(!this->tracePath.empty());
+
+    /* 依發車時間排定發車順序，並排入第一班車的發車事件 (自檢查點接續時已還原) */
+    if (!this->restored) {
+        dispatchOrder.resize(sche.size());
+        iota(dispatchOrder.begin(), dispatchOrder.end(), 0);
+        stable_sort(dispatchOrder.begin(), dispatchOrder.end(), [&](int a, int b) { return sche[a] < sche[b]; });
+        this->nextDispatch = 0;
+        this->scheduleDispatch();
+    }
+
+    /* 定期累積需求: 自首班車發車 (或接續的時刻) 起每 queueInterval 秒輸出一次各站候車人數 */
+    if (!this->queuePath.empty() && !eventList.empty()) {
+        queueWriter = make_shared<BufferedWriter>();
+        queueWriter->open(this->queuePath);
+        *queueWriter << "time";
+        for (int id = 0; id < this->stopAmount; id++) *queueWriter << "," << this->findStop(id)->stopName;
+        *queueWriter << "\n";
+        eventList.emplace(eventList.top().getTime(), -1, 5, 0, 1);
+    }
+
     while(!eventList.empty()) {
-        Event* currentEvent = eventList.top();
-        int eventType = currentEvent->getEventType();
-        auto it = eventSet.find(eventType);
-        if (it != eventSet.end()) {
-            it->second(currentEvent);
-        } else {
+        if (this->checkpointAt >= 0 && eventList.top().getTime() >= this->checkpointAt) {  // 到達儲存時刻: 處理該時刻的事件前儲存
+            this->saveCheckpoint(this->checkpointPath);
+            this->checkpointAt = -1;
+            if (this->checkpointStop) break;
+        }
+        if (this->pauseAt >= 0 && eventList.top().getTime() >= this->pauseAt) {  // 到達暫停時刻: 保留事件列表，之後可 fork 或再次呼叫 simulation 繼續
+            this->pauseAt = -1;
+            this->restored = true;
+            return;
+        }
+        PROFILE_QUEUE(profile, eventList.size());
+        Event currentEvent = eventList.top();
+        eventList.pop(); // 先移出再處理，避免處理函式推入同時刻的新事件後被誤刪
+        int eventType = currentEvent.getEventType();
+        if (eventType < 1 || eventType > 6) {
             throw runtime_error("未知的事件種類: " + to_string(eventType));
         }
-        eventList.pop();
+        {
+            PROFILE_SCOPE(profile, static_cast<Section>(eventType));
+            switch (eventType) {
+                case 1: this->arriveAtStop(currentEvent); break; // 事件 1: 公車到站
+                case 2: this->deptFromStop(currentEvent); break; // 事件 2: 公車離站
+                case 3: this->arriveAtLight(currentEvent); break; // 事件 3: 公車到號誌化路口
+                case 4: this->deptFromLight(currentEvent); break; // 事件 4: 公車離開號誌化路口
+                case 5: this->accrueDemand(currentEvent); break; // 事件 5: 定期累積各站需求
+                case 6: this->enterBerth(currentEvent); break; // 事件 6: 排隊中的公車進入停靠席位
+            }
+        }
+        this->eventCount++;
+        if (recording && eventType != 5) this->recordTrajectory(currentEvent);
     }
+
+    if (recording) trajectory.write(this->trajectoryPath); // 模擬結束後一次寫出
+    if (queueWriter) queueWriter.reset(); // 解構時寫出並關閉
+    if (!this->tracePath.empty()) profile.writeTrace(this->tracePath);
+}
+
+void System::accrueDemand(const Event& e) {
+/**
+ * @brief 定期累積所有站點的候車需求，並輸出候車人數快照
+ *
+ * 只把各站自上次累積以來的需求加入 (與公車到站時的單站累積使用相同的到達率與時間點)，
+ * 因此開啟快照不會改變模擬結果。事件列表中仍有其他事件時才排入下一次累積，
+ * 最後一班車抵達終點站後模擬即可結束。
+ *
+ * @param e 當前的事件物件 (事件種類 5，不屬於任何車輛)
+ */
+    stopState.accrue(e.getTime());
+
+    *queueWriter << e.getTime();
+    for (double pax : stopState.pax) *queueWriter << "," << static_cast<int>(pax);
+    *queueWriter << "\n";
+
+    if (!eventList.empty()) eventList.emplace(e.getTime() + this->queueInterval, -1, 5, 0, 1);
+}
+
+void System::recordTrajectory(const Event& e) {
+/**
+ * @brief 將事件處理後的公車狀態 (時間、里程、速度、乘客數) 記錄至軌跡緩衝區
+ *
+ * 事件種類代碼與 `Event` 相同: 1 到站、2 離站、3 到達號誌、4 離開號誌、6 進入停靠席位。
+ *
+ * @param e 剛處理完的事件
+ */
+    int bus = e.getBusID(), slot = fleet.slotOf[bus];
+    trajectory.record(bus, e.getTime(), fleet.location[slot], fleet.vol[slot], fleet.pax[slot], e.getEventType());
 }
 
 void System::performance() {
     cout << ">>> Performance <<<\n";
     cout << "There were " << fleet.size() << " bus run today.\n";
     cout << "Each line consists of " << this->stopAmount << " stop.\n"; 
-    cout << "Total heawdway deviation: " << this->headwayDev / 1;
-    cout << "\nAvg headway deviation: " << this->headwayDev /(fleet.size() - 1);
+    if (this->replications > 1) cout << "Replications: " << this->replications << "\n";
+    cout << "Total heawdway deviation: " << this->headwayDev / this->replications;
+    cout << "\nAvg headway deviation: " << this->headwayDev / this->replications /(fleet.size() - 1);
+    cout << "\nHeadway cv: " << this->metrics.headway().cv();
+    auto percentiles = [](const TDigest& d) { // 無樣本時輸出 n/a (同 Metrics::writeQuantiles)
+        if (d.count() == 0) cout << "n/a";
+        else cout << d.quantile(0.9) << " / " << d.quantile(0.99) << " seconds";
+    };
+    cout << "\nHeadway p90 / p99: ";
+    percentiles(this->metrics.headwayQuantile());
+    cout << "\nDwell p90 / p99: ";
+    percentiles(this->metrics.dwellQuantile());
+    cout << "\nExcess wait time: " << this->metrics.excessWaitTime() << " seconds";
+    cout << "\nBunching episodes: " << this->metrics.bunchingEpisodes();
+    cout << "\nAvg load factor: " << this->metrics.load().mean;
+    cout << "\nAvg commercial speed: " << this->metrics.speed().mean << " kph";
+    if (this->metrics.berthWait().n) cout << "\nBerth waits: " << this->metrics.berthWait().n << " (avg " << this->metrics.berthWait().mean << " seconds)";
+    cout << "\n";
+
+#ifndef NO_PROFILE
+    cout << "\n";
+    this->profile.report(cout);
+#endif
+
+    if (!this->summaryPath.empty()) this->writeSummary(this->summaryPath);
+}
+
+void System::merge(const System& other) {
+/**
+ * @brief 合併另一次重複實驗 (相同設定檔) 的績效值與績效指標
+ *
+ * 班距偏差為累加值，輸出時再除以重複次數；`Metrics` 的累積器與分位數 sketch 皆可直接合併。
+ *
+ * @param other 另一次已完成模擬的系統
+ */
+    this->headwayDev += other.headwayDev;
+    this->replications += other.replications;
+    this->metrics.merge(other.metrics);
+    this->profile.merge(other.profile);
+    this->eventCount += other.eventCount;
+}
+
+void System::setVerbose(bool verbose) { this->out.enabled = verbose; }
+
+void System::setTrajectory(const string& path) { this->trajectoryPath = path; }
+
+void System::setTrace(const string& path) { this->tracePath = path; }
+
+void System::setQueueSnapshot(const string& path) { this->queuePath = path; }
+
+void System::setPause(int time) { this->pauseAt = time; }
+
+void System::setControl(const string& key, double value) {
+/**
+ * @brief 覆寫離站時的控制參數 (不影響已初始化的路線與班表，可於 fork 後套用)
+ *
+ * @param key 設定檔中的欄位名稱: time.schemeThreshold、time.Tmax、velocity.limit、velocity.low 或 general.scheme (1 或 2)
+ * @param value 新的數值 (單位同設定檔)
+ * @throws runtime_error 若欄位不是控制參數
+ */
+    if (key == "time.schemeThreshold") this->schemeThreshold = value;
+    else if (key == "time.Tmax") this->Tmax = static_cast<int>(value);
+    else if (key == "velocity.limit") this->Vlimit = value;
+    else if (key == "velocity.low") this->Vlow = value;
+    else if (key == "general.scheme" && (value == 1 || value == 2)) this->scheme = static_cast<int>(value);
+    else throw runtime_error("錯誤: '" + key + "' 不是可覆寫的控制參數");
+}
+
+bool System::isContinuousControl(const string& key) {
+    return key == "time.schemeThreshold" || key == "time.Tmax" || key == "velocity.limit" || key == "velocity.low";
+}
+
+unique_ptr<System> System::fork() const {
+/**
+ * @brief 複製目前的模擬狀態，供不同策略自同一狀態分支模擬
+ *
+ * 路線、班表、車隊、站點需求、績效與事件列表皆複製；亂數串流也一併複製，
+ * 因此各分支之後的發車間距、需求與速度抽樣完全相同 (common random numbers)，
+ * 差異只來自策略本身。複本的路線改指向其自有的站點與號誌，分支之間互不影響，可平行模擬。
+ *
+ * @return unique_ptr<System> 模擬狀態的複本
+ */
+    unique_ptr<System> copy(new System(*this));
+    copy->route.clear();
+    for (auto& stop : copy->stops) copy->route.insert(&stop);
+    for (auto& light : copy->lights) copy->route.insert(&light);
+    copy->queueWriter.reset();
+    return copy;
+}
+
+void System::seedStreams(optional<int64_t> seed) {
+/**
+ * @brief 設定各亂數串流的種子
+ *
+ * 路線 (站距、號誌間距)、班表 (發車間距)、乘客需求及行駛速度各自使用獨立的串流，
+ * 由同一個種子加上串流編號導出，因此改變某一部分的抽樣次數不會影響其他部分的隨機序列。
+ * 需求與速度只保存串流種子，每次抽樣再以公車、站點為鍵導出 (`KeyedRng`)，
+ * 使不同控制策略在同一種子下看到相同的隨機輸入 (common random numbers)。
+ *
+ * @param seed 種子；未指定時以 random_device 產生
+ */
+    uint64_t base = seed ? static_cast<uint64_t>(*seed) : (static_cast<uint64_t>(random_device{}()) << 32 | random_device{}());
+    auto stream = [&](uint32_t index) {
+        seed_seq seq{ static_cast<uint32_t>(base), static_cast<uint32_t>(base >> 32), index };
+        return mt19937(seq);
+    };
+    auto key = [&](uint32_t index) {
+        mt19937 gen = stream(index);
+        return (static_cast<uint64_t>(gen()) << 32) | gen();
+    };
+    routeGen = stream(0);
+    scheduleGen = stream(1);
+    demandSeed = key(2);
+    speedSeed = key(3);
+}
+
+void System::saveCheckpoint(const string& path) {
+/**
+ * @brief 將模擬狀態寫入二進位檢查點
+ *
+ * 內容: 路線元素里程與站點上一班車到站時間、班表與發車順序、車隊狀態、站點候車需求、
+ * 績效累積器、事件列表 (不含定期累積需求事件)、headway deviation 及亂數串流狀態。
+ * 設定參數 (速度分佈、門檻、時制等) 不寫入，接續時以當次設定檔為準，可用於比較不同策略。
+ * 軌跡、trace 與候車人數快照等輸出緩衝區不寫入。
+ *
+ * @param path 檢查點檔案路徑
+ */
+    CheckpointWriter out(path);
+
+    /* 路線 (里程為初始化時隨機產生，須還原才能與檢查點一致) */
+    out.put(this->stopAmount);
+    out.put(route.size());
+    for (auto& element : route) {
+        if (holds_alternative<Stop*>(element)) {
+            Stop* stop = get<Stop*>(element);
+            out.put(0);
+            out.put(stop->id);
+            out.put(stop->mileage);
+            out.put(stop->lastArrive);
+        } else {
+            Light* light = get<Light*>(element);
+            out.put(1);
+            out.put(light->id);
+            out.put(light->mileage);
+        }
+    }
+
+    /* 班表與車隊 */
+    out.put(sche);
+    out.put(dispatchOrder);
+    out.put(this->nextDispatch);
+    fleet.save(out);
+    stopState.save(out);
+    out.put(signalQueue);
+    metrics.save(out);
+
+    /* 事件列表 */
+    vector<Event> events;
+    for (auto queue = eventList; !queue.empty(); queue.pop()) {
+        if (queue.top().getEventType() != 5) events.push_back(queue.top());
+    }
+    out.put(events);
+
+    out.put(lastPass);
+    out.put(this->headwayDev);
+    out.put(this->eventCount);
+    for (auto* gen : { &routeGen, &scheduleGen }) out.putEngine(*gen);
+    out.put(this->demandSeed);
+    out.put(this->speedSeed);
+
+    this->out << "Checkpoint saved: " << path << " (" << events.size() << " events, " << fleet.active.size() << " buses in service)\n";  // 與事件記錄相同，受 output.verbose 控制 (批次報表不混入)
+}
+
+void System::loadCheckpoint(const string& path) {
+/**
+ * @brief 自檢查點還原模擬狀態 (須先以相同路線資料完成 init)
+ *
+ * @param path 檢查點檔案路徑
+ * @throws runtime_error 若檔案損毀或路線與檢查點不符
+ */
+    CheckpointReader in(path);
+
+    int stops;
+    size_t elements;
+    in.get(stops);
+    in.get(elements);
+    if (stops != this->stopAmount || elements != route.size()) {
+        throw runtime_error("檢查點的路線 (" + to_string(stops) + " 站, " + to_string(elements) + " 個元素) 與目前設定不符");
+    }
+
+    /* 依編號還原里程後重建路線 (路線依里程排序) */
+    vector<Stop*> stopById(this->stopAmount, nullptr);
+    vector<Light*> lightById(elements, nullptr);
+    for (auto& element : route) {
+        if (holds_alternative<Stop*>(element)) stopById[get<Stop*>(element)->id] = get<Stop*>(element);
+        else lightById[get<Light*>(element)->id] = get<Light*>(element);
+    }
+    vector<variant<Stop*, Light*>> ordered;
+    for (size_t i = 0; i < elements; i++) {
+        int type, id;
+        in.get(type);
+        in.get(id);
+        if (type == 0 && id >= 0 && id < this->stopAmount && stopById[id]) {
+            in.get(stopById[id]->mileage);
+            in.get(stopById[id]->lastArrive);
+            ordered.push_back(stopById[id]);
+        } else if (type == 1 && id >= 0 && static_cast<size_t>(id) < elements && lightById[id]) {
+            in.get(lightById[id]->mileage);
+            ordered.push_back(lightById[id]);
+        } else {
+            throw runtime_error("檢查點的路線元素與目前設定不符");
+        }
+    }
+    route.clear();
+    for (auto& element : ordered) route.insert(element);
+
+    /* 班表與車隊 */
+    in.get(sche);
+    in.get(dispatchOrder);
+    in.get(this->nextDispatch);
+    fleet.load(in);
+    stopState.load(in);
+    in.get(signalQueue);
+    metrics.load(in);
+
+    /* 事件列表 */
+    vector<Event> events;
+    in.get(events);
+    eventList = priority_queue<Event, vector<Event>, eventCmp>(eventCmp(), move(events));
+
+    in.get(lastPass);
+    in.get(this->headwayDev);
+    in.get(this->eventCount);
+    for (auto* gen : { &routeGen, &scheduleGen }) in.getEngine(*gen);
+    in.get(this->demandSeed);
+    in.get(this->speedSeed);
+    if (!in.done()) throw runtime_error("檢查點檔案損毀 (多餘的資料)");
+
+    this->restored = true;
+    this->out << "Checkpoint restored: " << path << " (" << eventList.size() << " events, " << fleet.active.size() << " buses in service)\n";
+}
+
+void System::writeSummary(const string& path) {
+/**
+ * @brief 將本次模擬的績效摘要以 JSON 格式寫入檔案
+ *
+ * 摘要包含路線基本資料、班距偏差總和與平均值，以及 `Metrics` 記錄的
+ * 各站、各車績效指標，供後處理腳本直接讀取。
+ *
+ * @param path 輸出檔案路徑
+ * @throws runtime_error 若無法開啟輸出檔案
+ */
+    ofstream file(path);
+    if (!file) {
+        throw runtime_error("無法開啟輸出檔案 " + path);
+    }
+
+    file << setprecision(10);
+    file << "{\"route\":\"" << this->routeName << "\"";
+    file << ",\"fleet\":" << fleet.size();
+    file << ",\"stops\":" << this->stopAmount;
+    file << ",\"replications\":" << this->replications;
+    file << ",\"headwayDeviation\":{\"total\":" << this->headwayDev / this->replications;
+    file << ",\"avg\":" << this->headwayDev / this->replications / (fleet.size() - 1) << "}";
+    file << ",\"metrics\":";
+    this->metrics.writeJson(file);
+    file << "}\n";
 }
 
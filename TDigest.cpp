@@ -0,0 +1,130 @@
+#include "TDigest.hpp"
+#include "Checkpoint.hpp"
+
+TDigest::TDigest(double compression) : compression(compression) {}
+
+void TDigest::add(double x, double weight) {
+/**
+ * @brief 加入一筆樣本；緩衝區滿時才進行壓縮，使每筆樣本的平均成本為常數
+ *
+ * @param x 樣本值
+ * @param weight 樣本權重
+ */
+    buffer.push_back({x, weight});
+    minValue = min(minValue, x);
+    maxValue = max(maxValue, x);
+    if (buffer.size() >= static_cast<size_t>(4 * compression)) {
+        this->compress();
+    }
+}
+
+void TDigest::merge(const TDigest& other) {
+/**
+ * @brief 合併另一個 sketch，將其質心視為加權樣本重新壓縮
+ *
+ * @param other 另一個 sketch
+ */
+    other.compress();
+    for (auto& c : other.centroids) {
+        buffer.push_back(c);
+    }
+    minValue = min(minValue, other.minValue);
+    maxValue = max(maxValue, other.maxValue);
+    this->compress();
+}
+
+double TDigest::scale(double q) const {
+    return compression / (2 * M_PI) * asin(2 * q - 1);
+}
+
+void TDigest::compress() const {
+/**
+ * @brief 將緩衝區的樣本與現有質心依平均值排序後合併
+ *
+ * 以 k1 尺度函數 k(q) = δ/(2π)·asin(2q-1) 限制每個質心涵蓋的分位範圍不超過 1，
+ * 使兩端 (p1、p99) 的質心較小、精度較高，質心數量上限約為 δ。
+ */
+    if (buffer.empty()) return;
+
+    for (auto& c : centroids) {
+        buffer.push_back(c);
+    }
+    sort(buffer.begin(), buffer.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+
+    total = 0;
+    for (auto& c : buffer) {
+        total += c.weight;
+    }
+
+    centroids.clear();
+    Centroid current = buffer[0];
+    double weightSoFar = 0;
+    double kLow = this->scale(0);
+    for (size_t i = 1; i < buffer.size(); i++) {
+        double proposed = weightSoFar + current.weight + buffer[i].weight;
+        if (this->scale(proposed / total) - kLow <= 1) { // 仍在容許範圍內，併入目前的質心
+            current.weight += buffer[i].weight;
+            current.mean += (buffer[i].mean - current.mean) * buffer[i].weight / current.weight;
+        } else { // 超出範圍，開新的質心
+            weightSoFar += current.weight;
+            kLow = this->scale(weightSoFar / total);
+            centroids.push_back(current);
+            current = buffer[i];
+        }
+    }
+    centroids.push_back(current);
+    buffer.clear();
+}
+
+double TDigest::quantile(double q) const {
+/**
+ * @brief 計算第 q 分位數，於相鄰質心中心之間線性內插
+ *
+ * @param q 分位 (0 <= q <= 1)
+ * @return double 分位數；若沒有任何樣本則回傳 NaN
+ */
+    this->compress();
+    if (centroids.empty()) return numeric_limits<double>::quiet_NaN();
+    if (centroids.size() == 1) return centroids[0].mean;
+
+    double index = clamp(q, 0.0, 1.0) * total;
+    double prevCenter = 0, prevMean = minValue, cumulative = 0;
+    for (auto& c : centroids) {
+        double center = cumulative + c.weight / 2;
+        if (index < center) {
+            double t = (center > prevCenter) ? (index - prevCenter) / (center - prevCenter) : 0;
+            return prevMean + t * (c.mean - prevMean);
+        }
+        prevCenter = center;
+        prevMean = c.mean;
+        cumulative += c.weight;
+    }
+
+    /* 落在最後一個質心中心之後，與最大值內插 */
+    double t = (total > prevCenter) ? (index - prevCenter) / (total - prevCenter) : 1;
+    return prevMean + t * (maxValue - prevMean);
+}
+
+double TDigest::count() const { return total + accumulate(buffer.begin(), buffer.end(), 0.0, [](double s, const Centroid& c) { return s + c.weight; }); }
+
+size_t TDigest::size() const { return centroids.size() + buffer.size(); }
+
+void TDigest::save(CheckpointWriter& out) const {
+    out.put(compression);
+    out.put(centroids);
+    out.put(buffer);
+    out.put(total);
+    out.put(minValue);
+    out.put(maxValue);
+}
+
+void TDigest::load(CheckpointReader& in) {
+    in.get(compression);
+    in.get(centroids);
+    in.get(buffer);
+    in.get(total);
+    in.get(minValue);
+    in.get(maxValue);
+}
@@ -0,0 +1,144 @@
+#include "Trajectory.hpp"
+#include "Writer.hpp"
+
+void Trajectory::reserve(int busAmount, size_t pointsPerBus) {
+/**
+ * @brief 預先配置每車的欄位緩衝區，避免模擬過程中反覆配置記憶體
+ *
+ * @param busAmount 車輛數量
+ * @param pointsPerBus 每車預計的軌跡點數 (通常為路線元素數量的兩倍)
+ */
+    reserved = pointsPerBus;
+    if (buses.size() < static_cast<size_t>(busAmount)) buses.resize(busAmount);
+    for (auto& c : buses) {
+        c.dTime.reserve(pointsPerBus);
+        c.dMileage.reserve(pointsPerBus);
+        c.velocity.reserve(pointsPerBus);
+        c.pax.reserve(pointsPerBus);
+        c.event.reserve(pointsPerBus);
+    }
+}
+
+void Trajectory::clear() {
+    for (auto& c : buses) {
+        c = Columns();
+    }
+    this->reserve(buses.size(), reserved);
+}
+
+void Trajectory::record(int busID, int time, int mileage, double velocity, int pax, int eventType) {
+/**
+ * @brief 記錄一筆軌跡點，時間與里程以相對該車上一點的差值儲存
+ *
+ * @param busID 公車編號
+ * @param time 時間 (秒)
+ * @param mileage 位置 (公尺)
+ * @param velocity 速度 (m/s)
+ * @param pax 車上乘客數
+ * @param eventType 事件種類代碼
+ * @throws runtime_error 若時間或里程差超出 16 位元範圍 (同一車相鄰兩點相隔超過約 18 小時或 65 公里)
+ */
+    if (static_cast<size_t>(busID) >= buses.size()) {
+        buses.resize(busID + 1);
+        buses[busID].dTime.reserve(reserved);
+        buses[busID].dMileage.reserve(reserved);
+        buses[busID].velocity.reserve(reserved);
+        buses[busID].pax.reserve(reserved);
+        buses[busID].event.reserve(reserved);
+    }
+
+    Columns& c = buses[busID];
+    if (c.baseTime < 0) {
+        c.baseTime = c.lastTime = time;
+        c.baseMileage = c.lastMileage = mileage;
+    }
+
+    int dTime = time - c.lastTime;
+    int dMileage = mileage - c.lastMileage;
+    if (dTime < 0 || dTime > UINT16_MAX || dMileage < 0 || dMileage > UINT16_MAX) {
+        throw runtime_error("公車 " + to_string(busID) + " 的軌跡差值超出記錄範圍");
+    }
+
+    c.dTime.push_back(dTime);
+    c.dMileage.push_back(dMileage);
+    c.velocity.push_back(static_cast<uint16_t>(clamp(velocity * 100, 0.0, static_cast<double>(UINT16_MAX))));
+    c.pax.push_back(static_cast<uint16_t>(max(0, pax)));
+    c.event.push_back(static_cast<uint8_t>(eventType));
+    c.lastTime = time;
+    c.lastMileage = mileage;
+}
+
+size_t Trajectory::size() const {
+    size_t total = 0;
+    for (auto& c : buses) total += c.event.size();
+    return total;
+}
+
+size_t Trajectory::bytes() const {
+    return this->size() * (3 * sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint8_t));
+}
+
+void Trajectory::write(const string& path) const {
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+        this->writeBinary(path);
+    } else {
+        this->writeCsv(path);
+    }
+}
+
+void Trajectory::writeCsv(const string& path) const {
+/**
+ * @brief 依公車編號逐車還原差值並輸出 CSV
+ *
+ * 欄位: bus, time (秒), mileage (公尺), velocity (m/s), event (事件種類代碼), load (車上乘客數)
+ *
+ * @param path 輸出檔案路徑
+ */
+    BufferedWriter writer;
+    writer.open(path);
+    writer << "bus,time,mileage,velocity,event,load\n";
+    for (size_t id = 0; id < buses.size(); id++) {
+        const Columns& c = buses[id];
+        int time = c.baseTime, mileage = c.baseMileage;
+        for (size_t i = 0; i < c.event.size(); i++) {
+            time += c.dTime[i];
+            mileage += c.dMileage[i];
+            writer << static_cast<int>(id) << ',' << time << ',' << mileage << ',' << c.velocity[i] / 100.0 << ','
+                   << static_cast<int>(c.event[i]) << ',' << static_cast<int>(c.pax[i]) << '\n';
+        }
+    }
+    writer.close();
+}
+
+void Trajectory::writeBinary(const string& path) const {
+/**
+ * @brief 以二進位欄位格式輸出 (little-endian)
+ *
+ * 檔頭: "BTRJ", 版本 (uint32), 車輛數 (uint32)
+ * 每車: 編號、點數、起始時間、起始里程 (皆 uint32)，接著依序為
+ *       dTime[], dMileage[], velocity[], pax[] (uint16) 與 event[] (uint8) 欄位
+ *
+ * @param path 輸出檔案路徑
+ */
+    BufferedWriter writer;
+    writer.open(path);
+    uint32_t header[2] = {1, static_cast<uint32_t>(buses.size())};
+    writer.write("BTRJ", 4);
+    writer.write(header, sizeof(header));
+    for (size_t id = 0; id < buses.size(); id++) {
+        const Columns& c = buses[id];
+        uint32_t meta[4] = {
+            static_cast<uint32_t>(id),
+            static_cast<uint32_t>(c.event.size()),
+            static_cast<uint32_t>(max(0, c.baseTime)),
+            static_cast<uint32_t>(c.baseMileage)
+        };
+        writer.write(meta, sizeof(meta));
+        writer.write(c.dTime.data(), c.dTime.size() * sizeof(uint16_t));
+        writer.write(c.dMileage.data(), c.dMileage.size() * sizeof(uint16_t));
+        writer.write(c.velocity.data(), c.velocity.size() * sizeof(uint16_t));
+        writer.write(c.pax.data(), c.pax.size() * sizeof(uint16_t));
+        writer.write(c.event.data(), c.event.size() * sizeof(uint8_t));
+    }
+    writer.close();
+}
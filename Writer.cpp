@@ -0,0 +1,85 @@
+#include "Writer.hpp"
+#include <charconv>
+
+BufferedWriter::BufferedWriter(size_t capacity) : buffer(capacity) {}
+
+BufferedWriter::~BufferedWriter() { this->close(); }
+
+void BufferedWriter::open(const string& path) {
+/**
+ * @brief 開啟輸出檔案，若已有開啟的檔案則先關閉
+ *
+ * @param path 輸出檔案路徑
+ * @throws runtime_error 若無法開啟檔案
+ */
+    this->close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw runtime_error("無法開啟輸出檔案 " + path);
+    }
+}
+
+void BufferedWriter::close() {
+    if (!file) return;
+    this->flush();
+    fclose(file);
+    file = nullptr;
+}
+
+void BufferedWriter::flush() {
+    if (file && used) {
+        fwrite(buffer.data(), 1, used, file);
+    }
+    used = 0;
+}
+
+char* BufferedWriter::reserve(size_t size) {
+/**
+ * @brief 確保緩衝區尚有 `size` bytes 可用，不足時先寫出緩衝區
+ *
+ * @param size 需要的長度
+ * @return char* 可寫入的位置
+ */
+    if (used + size > buffer.size()) {
+        this->flush();
+        if (size > buffer.size()) buffer.resize(size);
+    }
+    return buffer.data() + used;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c) {
+    *this->reserve(1) = c;
+    used++;
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(const char* s) {
+    this->write(s, strlen(s));
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(const string& s) {
+    this->write(s.data(), s.size());
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(int v) {
+    return *this << static_cast<long long>(v);
+}
+
+BufferedWriter& BufferedWriter::operator<<(long long v) {
+    char* p = this->reserve(24);
+    used += to_chars(p, p + 24, v).ptr - p;
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(double v) {
+    char* p = this->reserve(32);
+    used += to_chars(p, p + 32, v, chars_format::general, 10).ptr - p;
+    return *this;
+}
+
+void BufferedWriter::write(const void* data, size_t size) {
+    memcpy(this->reserve(size), data, size);
+    used += size;
+}
@@ -0,0 +1,410 @@
+#include <bits/stdc++.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+#include "System.hpp"
+#include "Generator.hpp"
+#include "Replay.hpp"
+#include "Online.hpp"
+#include "Horizon.hpp"
+
+using namespace std;
+
+/* 基準測試情境 */
+struct Scenario {
+    GeneratorConfig config; // 情境產生參數
+    int repeat; // 最少重複模擬次數 (小情境重複以取得穩定的量測)
+};
+
+/* 單一情境的量測結果 (由子行程透過 pipe 回傳) */
+struct Result {
+    long long events = 0; // 處理的事件數
+    int runs = 0; // 實際重複模擬次數
+    double initMs = 0; // 平均初始化時間 (毫秒)
+    double simSeconds = 0; // 模擬總耗時 (秒)
+    long long peakRssKb = 0; // 最大常駐記憶體 (KB)
+    long long handlerCount[5] = {}; // 各事件種類的處理次數
+    double handlerNanos[5] = {}; // 各事件種類的累積耗時 (奈秒)
+    size_t queueHighWater = 0; // 事件列表長度高水位
+    long long cacheMisses = -1; // 模擬期間的快取未命中次數 (-1 表示無法取得硬體計數器)
+    size_t gtfsRows = 0; // GTFS 情境: stop_times 列數
+    double gtfsLoadMs = 0; // GTFS 情境: 單獨讀取路線班表的時間 (毫秒)
+};
+
+/* 硬體快取未命中計數器 (perf_event_open；虛擬機或權限不足時不可用) */
+struct CacheCounter {
+    int fd = -1;
+
+    CacheCounter() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~CacheCounter() { if (fd >= 0) close(fd); }
+
+    bool available() const { return fd >= 0; }
+    void start() { if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); }
+    void stop() { if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); }
+    long long value() const {
+        long long count = 0;
+        if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+    }
+};
+
+/* 基準值 */
+struct Baseline {
+    double eventsPerSec; // 每秒事件數
+    double initMs; // 初始化時間 (毫秒)
+    long long peakRssKb; // 最大常駐記憶體 (KB)
+};
+
+Scenario makeScenario(const string& name, int stops, int signals, double signalDist, int trips, double headway, double headwaySd, int repeat, int days = 1, int gtfsRoutes = 0, int berths = 0, bool overtaking = true, double congestion = 0, double traffic = 0, int scheme = 1) {
+    GeneratorConfig config;
+    config.route = name;
+    config.stops = stops;
+    config.signals = signals;
+    config.signalDist = signalDist;
+    config.trips = trips;
+    config.headway = headway;
+    config.headwaySd = headwaySd;
+    config.days = days;
+    config.gtfsRoutes = gtfsRoutes;
+    config.berths = berths;
+    config.overtaking = overtaking;
+    config.congestion = congestion;
+    config.traffic = traffic;
+    config.scheme = scheme;
+    config.simulationSeed = config.seed; // 固定模擬種子，各次量測處理相同的事件序列
+    return { config, repeat };
+}
+
+const vector<Scenario> scenarios = {
+    makeScenario("307",         50,  70, 250, 12,   5,    1,   50), // 現行 307 路線設定 (config.toml)
+    makeScenario("dense-200",  200, 600, 100, 12,   5,    1,    5), // 200 站、密集號誌
+    makeScenario("fleet-2000",  20,  28, 250, 2000, 0.65, 0.2,  1), // 2,000 班次
+    makeScenario("day-24h",     50,  70, 250, 288,  5,    1,    1), // 全日班表 (00:00 - 24:00 發車)
+    makeScenario("week-7d",     20,  28, 250, 288,  5,    1,    1, 7), // 七日班表 (平日/週末時制與需求)
+    makeScenario("gtfs-city",   40,  56, 250, 150,  5,    1,    1, 1, 150), // 城市規模 GTFS feed (150 路線, 約 90 萬筆 stop_times)
+    makeScenario("berths-2",    50,  70, 250, 288,  3,    1,    1, 1, 0, 2), // 每站 2 個停靠席位、3 分鐘班距 (排隊與依序離站)
+    makeScenario("follow-2000", 20,  28, 250, 2000, 0.65, 0.2,  1, 1, 0, 0, false), // 2,000 班次、禁止超車 (依先後順序 O(1) 查找前車)
+    makeScenario("congested",   50,  70, 250, 288,  5,    1,    1, 1, 0, 0, true, 0.6), // 全日班表、尖峰路段背景車流降速 (路段速度查表)
+    makeScenario("queued",      50,  70, 250, 288,  5,    1,    1, 1, 0, 0, true, 0, 600), // 全日班表、路口一般車流停等 (每週期快取的紓解模型)
+    makeScenario("predictive",  50,  70, 250, 288,  5,    1,    1, 1, 0, 0, true, 0, 0, 2), // 全日班表、策略二 (每次離站試算 21 組候選的預測控制)
+};
+
+Result runScenario(const Scenario& sc, const string& dir) {
+/**
+ * @brief 執行情境並量測初始化時間、事件處理速度與各事件處理耗時
+ *
+ * 至少重複 repeat 次，且模擬總耗時至少 minSeconds (種子固定，每次模擬處理相同的事件序列)，
+ * 避免只需數十毫秒的情境受計時誤差與其他行程干擾影響。
+ */
+    const double minSeconds = 0.25;
+    Result result;
+    CacheCounter misses;
+    double initTotal = 0;
+    for (; result.runs < sc.repeat || result.simSeconds < minSeconds; result.runs++) {
+        System system;
+        auto start = chrono::steady_clock::now();
+        system.init(dir + "/config.toml");
+        auto mid = chrono::steady_clock::now();
+        misses.start();
+        system.simulation();
+        misses.stop();
+        auto end = chrono::steady_clock::now();
+
+        initTotal += chrono::duration<double, milli>(mid - start).count();
+        result.simSeconds += chrono::duration<double>(end - mid).count();
+        result.events += system.getEventCount();
+        for (int t = 1; t < 5; t++) {
+            result.handlerCount[t] += system.getProfile().count(static_cast<Section>(t));
+            result.handlerNanos[t] += system.getProfile().nanos(static_cast<Section>(t));
+        }
+        result.queueHighWater = max(result.queueHighWater, system.getProfile().getQueueHighWater());
+    }
+    result.initMs = initTotal / result.runs;
+
+    /* GTFS 情境另外單獨量測班表讀取時間 (init 中還包含站點、號誌等其他設定) */
+    if (sc.config.gtfsRoutes > 0) {
+        Gtfs feed(dir + "/data/gtfs");
+        auto start = chrono::steady_clock::now();
+        feed.load(sc.config.route);
+        result.gtfsLoadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        result.gtfsRows = feed.getStopTimeRows();
+    }
+    if (misses.available()) result.cacheMisses = misses.value();
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peakRssKb = usage.ru_maxrss;
+    return result;
+}
+
+Result runIsolated(const Scenario& sc, const string& dir) {
+/**
+ * @brief 於子行程中執行情境，使每個情境的最大常駐記憶體各自獨立量測
+ */
+    int fd[2];
+    if (pipe(fd) != 0) throw runtime_error("無法建立 pipe");
+    cout.flush();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        cout.setstate(ios::failbit); // 子行程只回傳量測結果，不輸出模擬訊息
+        Result result = runScenario(sc, dir);
+        ssize_t written = write(fd[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+
+    close(fd[1]);
+    Result result;
+    ssize_t got = read(fd[0], &result, sizeof(result));
+    close(fd[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (got != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw runtime_error("情境 " + sc.config.route + " 執行失敗");
+    }
+    return result;
+}
+
+map<string, Baseline> readBaseline(const string& path) {
+    map<string, Baseline> baseline;
+    ifstream file(path);
+    string line;
+    getline(file, line); // 跳過標題行
+    while (getline(file, line)) {
+        stringstream ss(line);
+        string name, field;
+        Baseline b;
+        getline(ss, name, ',');
+        getline(ss, field, ','); b.eventsPerSec = stod(field);
+        getline(ss, field, ','); b.initMs = stod(field);
+        getline(ss, field, ','); b.peakRssKb = stoll(field);
+        baseline[name] = b;
+    }
+    return baseline;
+}
+
+int main(int argc, char** argv) {
+/**
+ * @brief 執行所有基準情境並與基準檔比較
+ *
+ * 用法: ./bench1 [--update | --scenarios] [baseline.csv]
+ * --update 以本次結果覆寫基準檔；否則相對事件處理速度下降超過 20% 或記憶體用量增加超過 10% 時回傳 1。
+ * 相對事件處理速度: 各情境與基準檔的速度比除以所有情境速度比的中位數 (機器速度的差異)，
+ * 基準檔與本次量測不在同一台機器上時仍可比較；所有情境等比例變慢時須以中位數另行確認。
+ * --scenarios 只輸出各情境目錄 (供 make pgo 訓練使用)，不執行量測。
+ */
+    bool update = false;
+    string baselinePath = "bench/baseline.csv";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--update") update = true;
+        else if (arg == "--scenarios") {
+            for (auto& sc : scenarios) Generator(sc.config).writeAll("bench/scenarios/" + sc.config.route);
+            return 0;
+        }
+        else baselinePath = arg;
+    }
+
+    auto baseline = readBaseline(baselinePath);
+    map<string, Baseline> current;
+    bool regression = false;
+    const int rounds = 5; // 每個情境執行的輪數
+    const char* handlerName[] = { "", "arrStop", "depStop", "arrLight", "depLight" };
+
+    cout << left << setw(12) << "scenario" << right << setw(11) << "events/run" << setw(10) << "init ms"
+         << setw(12) << "events/s" << setw(10) << "rss KB";
+    for (int t = 1; t < 5; t++) cout << setw(12) << string("ns/") + handlerName[t];
+    cout << setw(8) << "queue" << setw(10) << "miss/ev" << "\n";
+
+    for (auto& sc : scenarios) Generator(sc.config).writeAll("bench/scenarios/" + sc.config.route);
+
+    /*
+     * 各輪依序執行所有情境 (而非同一情境連續執行多輪)，再取每個情境事件處理速度居中的一輪:
+     * 其他行程干擾與虛擬機的時脈波動常持續數秒，連續執行時會使同一情境的各輪一起偏快或偏慢
+     */
+    vector<vector<Result>> runs(scenarios.size());
+    for (int round = 0; round < rounds; round++) {
+        for (size_t k = 0; k < scenarios.size(); k++) runs[k].push_back(runIsolated(scenarios[k], "bench/scenarios/" + scenarios[k].config.route));
+    }
+
+    for (size_t k = 0; k < scenarios.size(); k++) {
+        const string& name = scenarios[k].config.route;
+        sort(runs[k].begin(), runs[k].end(), [](const Result& a, const Result& b) { return a.events / a.simSeconds < b.events / b.simSeconds; });
+        Result r = runs[k][rounds / 2];
+        double eventsPerSec = r.events / r.simSeconds;
+        current[name] = { eventsPerSec, r.initMs, r.peakRssKb };
+
+        cout << left << setw(12) << name << right << setw(11) << r.events / r.runs << setw(10) << fixed << setprecision(2) << r.initMs
+             << setw(12) << setprecision(0) << eventsPerSec << setw(10) << r.peakRssKb;
+        for (int t = 1; t < 5; t++) {
+            cout << setw(12) << setprecision(0) << (r.handlerCount[t] ? r.handlerNanos[t] / r.handlerCount[t] : 0.0);
+        }
+        cout << setw(8) << r.queueHighWater;
+        if (r.cacheMisses >= 0) cout << setw(10) << setprecision(2) << double(r.cacheMisses) / r.events;
+        else cout << setw(10) << "n/a";
+        cout << "\n";
+        if (r.gtfsRows > 0) {
+            cout << "  gtfs load: " << r.gtfsRows << " stop_times rows in " << setprecision(1) << r.gtfsLoadMs << " ms ("
+                 << setprecision(0) << r.gtfsRows / r.gtfsLoadMs * 1000 << " rows/s)\n";
+        }
+    }
+
+    /* 與基準檔比較: 速度比先除以所有情境速度比的中位數，扣除機器速度的差異後再判斷個別情境是否變慢 */
+    vector<double> ratios;
+    for (auto& [name, b] : current) {
+        if (auto it = baseline.find(name); it != baseline.end()) ratios.push_back(b.eventsPerSec / it->second.eventsPerSec);
+    }
+    double machine = 1;
+    if (!ratios.empty()) {
+        nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2, ratios.end());
+        machine = ratios[ratios.size() / 2];
+    }
+    cout << "vs baseline (events/s relative to the median ratio x" << setprecision(2) << machine << "):\n";
+    for (auto& sc : scenarios) {
+        const string& name = sc.config.route;
+        cout << "  " << left << setw(12) << name << right;
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            cout << "(no baseline)\n";
+            continue;
+        }
+        double speed = (current[name].eventsPerSec / it->second.eventsPerSec / machine - 1) * 100;
+        double memory = (double(current[name].peakRssKb) / it->second.peakRssKb - 1) * 100;
+        cout << showpos << setprecision(1) << setw(7) << speed << "% events/s" << setw(7) << memory << "% rss" << noshowpos;
+        if (speed < -20 || memory > 10) {
+            cout << "  REGRESSION";
+            regression = true;
+        }
+        cout << "\n";
+    }
+
+    /* 定期累積需求: 數千個站點的單次全站累積耗時 */
+    {
+        const int stopCount = 5000, passes = 20000;
+        StopState stops;
+        stops.resize(stopCount);
+        for (int i = 0; i < stopCount; i++) stops.rate[i] = (i % 97) / 3600.0;
+        auto start = chrono::steady_clock::now();
+        for (int p = 1; p <= passes; p++) stops.accrue(p * 60.0);
+        double nanos = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / passes;
+        cout << "demand accrue: " << stopCount << " stops in " << setprecision(2) << nanos / 1000 << " us/pass ("
+             << setprecision(0) << stops.pax[stopCount - 1] << " pax at last stop)\n";
+    }
+
+    /* 預測控制: 前後各 2 輛車、預測 8 站的單次試算 (複製快照並推進約 40 次到站) */
+    {
+        Horizon model;
+        model.Vavg = 25 / 3.6;
+        model.Tmax = 180;
+        model.capacity = FleetState::capacity;
+        for (int k = 0; k < 50; k++) model.mileage.push_back(k * 350);
+        model.now = 3600;
+        model.from = 20;
+        model.last = model.from + model.stops;
+        model.first = model.from - 2;
+        for (int k = model.first; k <= model.last; k++) model.stop.push_back({ model.mileage[k], 0.02, 3, 3500.0, 3400.0 - 30 * (k - model.first) });
+        model.bus.push_back({ model.from + 1, 0, 30, 0.01, 300, 0 });
+        for (int b = 1; b <= 4; b++) {
+            int next = b <= 2 ? model.from + 1 + b : model.from + 2 - b;
+            model.bus.push_back({ next, 3600.0 + 20 * b, 25, 0.01, 300, 0 });
+        }
+        const int decisions = 50000;
+        double cost = 0;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < decisions; i++) cost += model.choose(15 / 3.6, 40 / 3.6, 25 / 3.6 + (i % 7) * 0.1).cost;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "mpc rollout: " << model.getRollouts() << " sub-simulations in " << setprecision(1) << seconds * 1000 << " ms ("
+             << setprecision(0) << model.getRollouts() / seconds << " /s, " << setprecision(1) << seconds / decisions * 1e6
+             << " us per decision, cost " << setprecision(2) << cost / decisions << ")\n";
+    }
+
+    /* AVL 重播: 串流讀取時間排序的定位記錄 (2,000 班車、每 5 秒一筆)，記憶體只與同時營運車輛數有關 */
+    {
+        string dir = "bench/scenarios/307";
+        auto config = toml::parse_file(dir + "/config.toml");
+        System system;
+        system.init(config);
+        auto mileages = system.getStopMileages();
+
+        const int busCount = 2000, dispatch = 60, interval = 5, dwell = 20;
+        const double speed = 6;
+        string avlPath = filesystem::absolute(dir + "/data/avl.csv").string();
+        {
+            BufferedWriter avl;
+            avl.open(avlPath);
+            avl << "bus,time,mileage\n";
+            vector<double> pos(busCount, 0);
+            vector<int> next(busCount, 1), wait(busCount, dwell);
+            int first = 0; // 第一輛尚未駛離終點站的車
+            for (int t = 0; first < busCount; t += interval) {
+                for (int b = first; b < busCount && b * dispatch <= t; b++) {
+                    if (next[b] >= static_cast<int>(mileages.size())) continue;
+                    if (wait[b] > 0) {
+                        wait[b] -= interval;
+                    } else {
+                        pos[b] = min<double>(pos[b] + speed * interval, mileages[next[b]]);
+                        if (pos[b] >= mileages[next[b]]) { next[b]++; wait[b] = dwell; }
+                    }
+                    avl << b << ',' << t << ',' << static_cast<int>(pos[b]) << '\n';
+                }
+                while (first < busCount && next[first] >= static_cast<int>(mileages.size())) first++;
+            }
+            avl.close();
+        }
+
+        if (!config.contains("replay")) config.insert("replay", toml::table{});
+        config["replay"].as_table()->insert_or_assign("file", avlPath);
+        Replay replay(system, config);
+        replay.run();
+        cout << "avl replay: " << replay.getRows() << " rows in " << setprecision(1) << replay.getSeconds() * 1000 << " ms ("
+             << setprecision(0) << replay.getRows() / replay.getSeconds() << " rows/s, peak " << replay.getPeakTracks() << " active buses)\n";
+        filesystem::remove(avlPath);
+
+        /* 線上模式: 同樣的車隊以到離站訊息逐則處理 (不含 socket 傳輸)，量測每則訊息的處理延遲 */
+        vector<tuple<int, int, int, bool>> events; // { 時間, 公車, 站點, 是否離站 }
+        for (int b = 0; b < busCount; b++) {
+            double t = b * dispatch;
+            for (int k = 0; k < static_cast<int>(mileages.size()); k++) {
+                if (k > 0) t += (mileages[k] - mileages[k - 1]) / speed;
+                events.emplace_back(static_cast<int>(t), b, k, false);
+                events.emplace_back(static_cast<int>(t) + dwell, b, k, true);
+                t += dwell;
+            }
+        }
+        sort(events.begin(), events.end());
+        Online online(system, config);
+        auto start = chrono::steady_clock::now();
+        for (auto& [time, bus, stop, depart] : events) {
+            online.handle("{\"type\":\"" + string(depart ? "depart" : "arrive") + "\",\"bus\":\"" + to_string(bus)
+                          + "\",\"stop\":" + to_string(stop) + ",\"time\":" + to_string(time) + "}");
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "online advice: " << online.getMessages() << " messages in " << setprecision(1) << seconds * 1000 << " ms (p50 "
+             << online.getLatency().quantile(0.5) << " us, p99 " << online.getLatency().quantile(0.99) << " us)\n";
+    }
+
+    if (update) {
+        ofstream file(baselinePath);
+        file << "scenario,events_per_sec,init_ms,peak_rss_kb\n";
+        for (auto& [name, b] : current) {
+            file << name << "," << fixed << setprecision(0) << b.eventsPerSec << "," << setprecision(3) << b.initMs << "," << b.peakRssKb << "\n";
+        }
+        cout << "baseline updated: " << baselinePath << "\n";
+        return 0;
+    }
+    return regression ? 1 : 0;
+}
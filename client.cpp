@@ -0,0 +1,123 @@
+#include <bits/stdc++.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* 重播的到離站事件 */
+struct Record {
+    int time; // 發生時間 (秒)
+    int bus; // 公車編號
+    int stop; // 站點編號 (該車的第幾個站點)
+    bool depart; // 離站 (否則為到站)
+};
+
+int main(int argc, char** argv) {
+/**
+ * @brief 線上模式的重播測試用戶端
+ *
+ * 用法: ./client1 <socket> <trajectory.csv> [--out 回覆檔案]
+ * 讀取模擬輸出的軌跡 (事件 1 到站、2 離站)，依時間順序逐則送出並等待回覆，
+ * 輸出來回延遲的分位數與伺服器端的處理延遲 ({"type":"stats"})。
+ */
+    if (argc < 3) {
+        cerr << "用法: ./client1 <socket> <trajectory.csv> [--out 回覆檔案]\n";
+        return 1;
+    }
+    string socketPath = argv[1], trajectoryPath = argv[2], outPath;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string key = argv[i];
+        if (key == "--out") outPath = argv[i + 1];
+        else {
+            cerr << "未知的參數: " << key << "\n";
+            return 1;
+        }
+    }
+
+    /* 讀取軌跡: 每車第 k 次到站為第 k 個站點 */
+    ifstream file(trajectoryPath);
+    if (!file) {
+        cerr << "無法開啟 " << trajectoryPath << "\n";
+        return 1;
+    }
+    vector<Record> records;
+    unordered_map<int, int> visited; // 各車已到達的站點數
+    string line;
+    getline(file, line);  // 欄位名稱: bus,time,mileage,velocity,event,load
+    while (getline(file, line)) {
+        int bus, time, event;
+        double mileage, velocity;
+        if (sscanf(line.c_str(), "%d,%d,%lf,%lf,%d", &bus, &time, &mileage, &velocity, &event) != 5) continue;
+        if (event == 1) records.push_back({ time, bus, visited[bus]++, false });
+        else if (event == 2 && visited[bus] > 0) records.push_back({ time, bus, visited[bus] - 1, true });
+    }
+    stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.time < b.time; });
+
+    /* 連線 */
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "socket 路徑過長\n";
+        return 1;
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        cerr << "無法連線至 " << socketPath << " (" << strerror(errno) << ")\n";
+        return 1;
+    }
+
+    string pending; // 尚未收到換行的回覆
+    char chunk[4096];
+    auto request = [&](const string& message) {
+        if (send(fd, message.data(), message.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(message.size())) {
+            throw runtime_error("送出失敗");
+        }
+        size_t end;
+        while ((end = pending.find('\n')) == string::npos) {
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n <= 0) throw runtime_error("連線已關閉");
+            pending.append(chunk, n);
+        }
+        string reply = pending.substr(0, end);
+        pending.erase(0, end + 1);
+        return reply;
+    };
+
+    ofstream out;
+    if (!outPath.empty()) out.open(outPath);
+    vector<double> latency; // 來回延遲 (微秒)
+    latency.reserve(records.size());
+    long long bunching = 0, errors = 0;
+    auto start = chrono::steady_clock::now();
+    try {
+        for (auto& r : records) {
+            string message = "{\"type\":\"" + string(r.depart ? "depart" : "arrive") + "\",\"bus\":\"" + to_string(r.bus)
+                           + "\",\"stop\":" + to_string(r.stop) + ",\"time\":" + to_string(r.time) + "}\n";
+            auto sent = chrono::steady_clock::now();
+            string reply = request(message);
+            latency.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - sent).count());
+            bunching += reply.find("\"bunching\":true") != string::npos;
+            errors += reply.find("\"error\"") != string::npos;
+            if (out) out << reply << "\n";
+        }
+    } catch (const exception& ex) {
+        cerr << ex.what() << "\n";
+        close(fd);
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    string stats = request("{\"type\":\"stats\"}\n");
+    close(fd);
+
+    cout << "Sent " << records.size() << " events (" << errors << " errors, " << bunching << " flagged as bunching) in "
+         << fixed << setprecision(3) << seconds << " s\n";
+    if (!latency.empty()) {
+        sort(latency.begin(), latency.end());
+        auto at = [&](double q) { return latency[min(latency.size() - 1, static_cast<size_t>(q * latency.size()))]; };
+        cout << setprecision(1) << "Round trip: p50 " << at(0.5) << " us, p99 " << at(0.99) << " us, p99.9 " << at(0.999)
+             << " us, max " << latency.back() << " us (" << setprecision(0) << records.size() / max(seconds, 1e-9) << " msg/s)\n";
+    }
+    cout << "Server: " << stats << "\n";
+}
@@ -0,0 +1,52 @@
+#include <bits/stdc++.h>
+#include "Generator.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+/**
+ * @brief 合成情境產生工具
+ *
+ * 用法: ./gen1 [--stops N] [--signals N] [--trips N] [--trials N] [--days N] [--gtfs 路線數] [--headway 分鐘] [--headway-sd 分鐘]
+ *              [--stop-dist 公尺] [--signal-dist 公尺] [--demand 人/小時] [--berths N] [--overtaking 0|1] [--congestion 0-1]
+ *              [--traffic 輛/小時] [--scheme 1|2] [--start HHMM] [--seed N] [--sim-seed N] [--out 目錄]
+ * 輸出 <目錄>/config.toml 及 <目錄>/data/{stops,signals,schedule}.csv，可直接以 System::init(<目錄>/config.toml) 執行。
+ * 指定 --gtfs 時以 <目錄>/data/gtfs 下的 GTFS feed 取代 schedule.csv。
+ */
+    GeneratorConfig config;
+    string out = "scenario";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string key = argv[i], value = argv[i + 1];
+        if (key == "--stops") config.stops = stoi(value);
+        else if (key == "--signals") config.signals = stoi(value);
+        else if (key == "--trips") config.trips = stoi(value);
+        else if (key == "--trials") config.trials = stoi(value);
+        else if (key == "--days") config.days = stoi(value);
+        else if (key == "--gtfs") config.gtfsRoutes = stoi(value);
+        else if (key == "--headway") config.headway = stod(value);
+        else if (key == "--headway-sd") config.headwaySd = stod(value);
+        else if (key == "--stop-dist") config.stopDist = stod(value);
+        else if (key == "--signal-dist") config.signalDist = stod(value);
+        else if (key == "--demand") config.demand = stod(value);
+        else if (key == "--berths") config.berths = stoi(value);
+        else if (key == "--overtaking") config.overtaking = stoi(value) != 0;
+        else if (key == "--congestion") config.congestion = stod(value);
+        else if (key == "--traffic") config.traffic = stod(value);
+        else if (key == "--scheme") config.scheme = stoi(value);
+        else if (key == "--start") config.startTime = value;
+        else if (key == "--seed") config.seed = stoul(value);
+        else if (key == "--sim-seed") config.simulationSeed = stoll(value);
+        else if (key == "--route") config.route = value;
+        else if (key == "--out") out = value;
+        else {
+            cerr << "未知的參數: " << key << "\n";
+            return 1;
+        }
+    }
+
+    Generator generator(config);
+    generator.writeAll(out);
+    cout << "Generated " << config.stops << " stops, " << config.signals << " signals, "
+         << config.trials << " x " << config.days << " days x " << config.trips << " trips in " << out << "\n";
+}
@@ -0,0 +1,84 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "Writer.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * 二進位檢查點讀寫
+ *
+ * 可直接複製的型別 (int, double, Event, Welford ...) 及其 vector 以原始位元組整塊寫出，
+ * 其餘型別 (pair, string, 亂數產生器) 逐欄位寫出。格式只保證同一版本、同一平台的程式可讀回。
+ */
+class CheckpointWriter {
+    public:
+        /* Constructor */
+        CheckpointWriter(const string& path); // 開啟檔案並寫入檔頭
+        ~CheckpointWriter() { writer.close(); }
+
+        template<typename T>
+        void put(const T& value) {
+            static_assert(is_trivially_copyable_v<T>, "checkpoint: 非可直接複製的型別需另行處理");
+            writer.write(&value, sizeof(T));
+        }
+        template<typename A, typename B>
+        void put(const pair<A, B>& value) { put(value.first); put(value.second); }
+        void put(const string& value) { put(value.size()); writer.write(value.data(), value.size()); }
+        template<typename T>
+        void put(const vector<T>& values) {
+            put(values.size());
+            if constexpr (is_trivially_copyable_v<T>) writer.write(values.data(), values.size() * sizeof(T));
+            else for (auto& v : values) put(v);
+        }
+        template<typename Engine>
+        void putEngine(const Engine& engine) { ostringstream os; os << engine; put(os.str()); } // 亂數產生器狀態
+
+    private:
+        BufferedWriter writer;
+};
+
+class CheckpointReader {
+    public:
+        /* Constructor */
+        CheckpointReader(const string& path); // 讀入整個檔案並檢查檔頭
+
+        template<typename T>
+        void get(T& value) {
+            static_assert(is_trivially_copyable_v<T>, "checkpoint: 非可直接複製的型別需另行處理");
+            read(&value, sizeof(T));
+        }
+        template<typename A, typename B>
+        void get(pair<A, B>& value) { get(value.first); get(value.second); }
+        void get(string& value) { size_t n; get(n); value.resize(n); read(value.data(), n); }
+        template<typename T>
+        void get(vector<T>& values) {
+            size_t n;
+            get(n);
+            if (n > (data.size() - pos)) throw runtime_error("檢查點檔案損毀 (長度錯誤)");
+            if constexpr (!is_default_constructible_v<T>) { // 例如 Event: 逐筆以位元組還原
+                values.clear();
+                values.reserve(n);
+                array<unsigned char, sizeof(T)> bytes;
+                for (size_t i = 0; i < n; i++) { read(bytes.data(), sizeof(T)); values.push_back(bit_cast<T>(bytes)); }
+            } else if constexpr (is_trivially_copyable_v<T>) {
+                values.resize(n);
+                read(values.data(), n * sizeof(T));
+            } else {
+                values.resize(n);
+                for (auto& v : values) get(v);
+            }
+        }
+        template<typename Engine>
+        void getEngine(Engine& engine) { string s; get(s); istringstream is(s); is >> engine; }
+        bool done() const { return pos == data.size(); }
+
+    private:
+        vector<char> data;
+        size_t pos = 0;
+
+        void read(void* out, size_t size); // 讀取 size bytes，不足時拋出例外
+};
+
+#endif
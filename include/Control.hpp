@@ -0,0 +1,35 @@
+#ifndef CONTROL_HPP
+#define CONTROL_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 速度建議結果 */
+struct Advice {
+    enum Adjust : uint8_t { None, TooClose, TooFar }; // 建議速度是否受下限 / 上限限制
+
+    double vol; // 建議行駛速度 (m/s)
+    int dwell; // 下一站的置站時間 (秒，含速度受下限限制時的持車時間)
+    double leaderHold = 0; // 前車增加的置站時間 (秒，速度受上限限制時由前車等候)
+    bool bunching = false; // 是否可能連班 (採用控制策略)
+    Adjust adjust = None;
+};
+
+/*
+ * 置站優先的速度建議 (策略一)
+ *
+ * 駛離站點時依與前車的距離、發車間距及下一站的預估置站時間決定行駛速度:
+ * 與前車距離足夠時以平均速度行駛；否則以 距離 / (發車間距 + 置站時間) 行駛，
+ * 低於速度下限時改以平均速度行駛並於下一站持車，高於速度上限時以上限行駛並由前車等候。
+ * 不含任何模擬狀態，可供模擬、AVL 重播及線上服務共用。
+ */
+struct SpeedAdvisor {
+    double Vlow; // 速度下限 (m/s)
+    double Vlimit; // 速度上限 (m/s)
+    double threshold; // 判定可能連班的門檻 (以平均速度行駛至前車位置的時間 / 發車間距)
+
+    Advice advise(double Vavg, int headway, int dwell, optional<double> distance) const; // 計算建議 (無前車時 distance 為空)
+};
+
+#endif
@@ -1,28 +1,31 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
+#include <cstdint>
+
+/* 事件 (16 bytes，以值存放於事件列表；存取函式皆為 constexpr，可在比較器與處理函式中內聯) */
 class Event {
     public:
         /* Constructor */
-        Event(int time, int busID, int eventType, int oneOfID, bool direction); 
+        constexpr Event(int time, int busID, int eventType, int oneOfID, bool direction)
+            : time(time), busID(busID), oneOfID(oneOfID), eventType(static_cast<uint8_t>(eventType)), direction(direction) {}
         // 給定發生時間, 車輛編號, 事件種類代碼, 號誌或站點 id, 方向
 
         /* Getter */
-        const int getEventType(); // 取得事件種類代碼
-        const int getTime(); // 取得發生時間
-        const int getBusID(); // 取得公車編號
-        const int getStopID(); // 取得站點編號
-        const bool getDirection(); // 取得方向
-        const int getLightID(); // 取得號誌編號
+        constexpr int getEventType() const { return eventType; } // 取得事件種類代碼
+        constexpr int getTime() const { return time; } // 取得發生時間
+        constexpr int getBusID() const { return busID; } // 取得公車編號 (事件種類 5 不屬於任何車輛，為 -1)
+        constexpr int getStopID() const { return oneOfID; } // 取得站點編號 (事件種類 1, 2)
+        constexpr bool getDirection() const { return direction; } // 取得方向
+        constexpr int getLightID() const { return oneOfID; } // 取得號誌編號 (事件種類 3, 4)
 
     private:
         int time; // 發生時間
         int busID; // 公車編號
-        int eventType; // 事件種類代碼
-        int stopID; // 站點編號
-        int lightID; // 號誌編號
+        int oneOfID; // 站點或號誌編號 (依事件種類而定)
+        uint8_t eventType; // 事件種類代碼
         bool direction; // 方向
 
 };
 
-#endif
\ No newline at end of file
+#endif
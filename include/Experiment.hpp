@@ -0,0 +1,56 @@
+#ifndef EXPERIMENT_HPP
+#define EXPERIMENT_HPP
+
+#include "System.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 單次模擬的績效摘要 (策略比較的目標值) */
+struct Outcome {
+    static constexpr int count = 4;
+    static constexpr array<const char*, count> names = { "headwayDeviation", "headwayCv", "excessWait", "bunchingEpisodes" };
+
+    array<double, count> values; // 平均班距偏差、班距變異係數、額外等候時間 (秒)、連班次數
+
+    static Outcome of(const System& system); // 取出已完成模擬的績效
+};
+
+/* 控制策略 (覆寫 System::setControl 可接受的參數) */
+struct Variant {
+    string name; // 名稱
+    vector<pair<string, double>> controls; // { 欄位名稱, 數值 }
+};
+
+/*
+ * 以同一設定檔執行多次模擬的實驗驅動程式
+ *
+ * 每次重複實驗只初始化一次路線與班表，各策略再自同一狀態 fork 模擬，
+ * 因此策略間的差異不含路線、班表、需求與速度抽樣的雜訊 (common random numbers)。
+ */
+class Experiment {
+    public:
+        /* Constructor */
+        Experiment(const string& configPath); // 讀取設定檔 ([compare] 區段)
+
+        /* Experiment */
+        void compare(); // 配對比較各策略並輸出與第一個策略的差異
+
+        /* 共用於其他以同一設定檔執行多次模擬的驅動程式 */
+        static toml::table batch(const toml::table& config); // 複製設定並關閉事件記錄、所有輸出與檢查點
+        static unique_ptr<System> prepare(const toml::table& config, uint64_t seed, int forkAt); // 以指定種子初始化 (關閉事件記錄與所有輸出) 並模擬至分支時刻
+        static double tQuantile(long long df); // 學生 t 分佈的 97.5% 分位數
+        static void parallelFor(int threads, long long tasks, const function<bool(long long, int)>& task); // 平行執行 task(工作, 執行緒)，工作中的例外於結束後重新拋出
+
+    private:
+        toml::table config; // 設定 (各次重複實驗以此為基礎修改種子與輸出)
+        vector<Variant> variants; // 比較的策略 (第一個為基準)
+        int runs; // 重複實驗次數
+        int threads; // 執行緒數
+        int forkAt = -1; // 分支時刻 (秒，-1 表示初始化後立即分支)
+        string outputPath; // 逐次結果輸出檔案 (CSV，空字串表示不輸出)
+        uint64_t baseSeed; // 第 r 次重複實驗使用種子 baseSeed + r
+};
+
+#endif
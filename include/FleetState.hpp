@@ -0,0 +1,70 @@
+#ifndef FLEETSTATE_HPP
+#define FLEETSTATE_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/* 班次生命週期: 尚未發車 -> 營運中 -> 已抵達終點站 */
+enum class TripState : uint8_t { Pending, Active, Finished };
+
+/*
+ * 車隊狀態 (structure of arrays)
+ *
+ * 班次 (trip) 以公車編號識別，事件與績效均使用公車編號；
+ * 車輛狀態則存放於車位 (slot) 陣列，僅營運中的班次佔用車位。
+ * 班次發車時取得車位 (優先重複使用已退出營運的車位)，抵達終點站時歸還，
+ * 因此車位陣列大小與前車搜尋的成本只與同時在路上的車輛數有關，與全日班次數無關。
+ */
+struct FleetState {
+    static constexpr int capacity = 60; // 容量 (全車隊相同)
+
+    /* 班次 (以公車編號為索引) */
+    vector<int> schedHeadway; // 表定發車間距
+    vector<TripState> state; // 生命週期狀態
+    vector<int> slotOf; // 所佔用的車位 (尚未發車時為 -1；抵達終點站後保留最後使用的車位)
+
+    /* 車位 (以車位編號為索引) */
+    vector<int> trip; // 佔用此車位的公車編號
+    vector<int> location; // 位置 (里程)
+    vector<double> vol; // 速度
+    vector<double> nextVol; // 號誌停等前的速度
+    vector<double> cruise; // 駛離站點時決定的巡航速度 (各路段速度不超過此值)
+    vector<int> pax; // 車上乘客
+    vector<int> dwell; // 累積置站時間
+    vector<int> stopDwell;
+    vector<int> lastGo; // 上一次駛離站點或號誌的時間
+    vector<int> headway; // 發車間距 (發車時由班次複製)
+    vector<double> dropRate; // 當站下車率 (到站時抽樣)
+    vector<pair<int, bool>> bunching; // 連班記錄 { 第幾站, 連班與否 }
+    vector<int> target; // 行駛中前往的路線元素 (停靠於站點或號誌時為 -1)
+    vector<int> eta; // 抵達 target 的時間
+
+    /* 車輛沿路線的先後順序 (雙向鏈結串列，禁止超車時用於 O(1) 查找前車) */
+    vector<int> ahead; // 前一輛車的車位 (最前方為 -1)
+    vector<int> behind; // 後一輛車的車位 (最後方為 -1)
+    int tail = -1; // 最後方的車位
+
+    vector<int> active; // 營運中的車位
+    vector<int> activeIndex; // 車位在 active 中的位置
+    vector<int> freeSlots; // 可重複使用的車位
+
+    int add(int hdwy); // 新增一個尚未發車的班次，回傳公車編號
+    int activate(int id); // 班次發車: 取得並初始化車位，回傳車位編號
+    void retire(int id); // 班次抵達終點站: 歸還車位
+    void reserve(size_t trips); // 預先配置 trips 個班次的空間
+    int leader(int slot) const; // 取得前車車位 (營運中且位置大於該車的車輛中最靠近者)，無前車時回傳 -1
+    int orderedLeader(int slot) const; // 同上，但沿先後順序查找 (禁止超車時使用)
+    void overtake(int slot); // 駛離站點時超越仍停靠於同一站的前車 (調整先後順序)
+    size_t size() const { return state.size(); } // 班次數量
+    bool empty() const { return state.empty(); }
+    size_t vehicles() const { return location.size(); } // 車位數量 (同時營運車輛數的高水位)
+
+    void save(CheckpointWriter& out) const; // 寫入檢查點
+    void load(CheckpointReader& in); // 自檢查點讀回
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 合成情境參數 */
+struct GeneratorConfig {
+    string route = "Synthetic"; // 路線名稱
+    int stops = 50; // 站點數量
+    int signals = 70; // 號誌數量
+    double stopDist = 350; // 平均站距 (公尺)
+    double signalDist = 250; // 平均號誌間距 (公尺)
+    string startTime = "0000"; // 首班車時間 (HHMM)
+    double headway = 5; // 平均發車間距 (分鐘)
+    double headwaySd = 1; // 發車間距標準差 (分鐘)
+    int trips = 12; // 每組班表每日的班次數
+    int days = 1; // 模擬天數 (多日時另產生週末時制與星期需求倍率)
+    int trials = 1; // 班表組數 (每次重複實驗可使用不同組)
+    int gtfsRoutes = 0; // GTFS feed 的路線數 (大於 0 時班表改以 GTFS feed 輸出)
+    double demand = 60; // 離峰每站平均到站人數 (人/小時)
+    int berths = 0; // 每站停靠席位數 (0 表示不限)
+    bool overtaking = true; // 是否允許公車在路段上超車
+    double traffic = 0; // 各路口一般車流量的平均值 (輛/小時，0 表示不使用停等車隊模型)
+    double congestion = 0; // 尖峰時段背景車流的速度降幅 (0 - 1，0 表示不輸出路段速度表)
+    int scheme = 1; // 控制策略 (1: 置站優先, 2: 滾動時域預測控制)
+    unsigned seed = 2024; // 亂數種子
+    long long simulationSeed = -1; // 模擬的亂數種子 (寫入 general.seed，-1 表示不固定)
+};
+
+/* Synthetic route / signal / schedule generator (輸出格式與 System 讀取的格式相同) */
+class Generator {
+    public:
+        /* Constructor */
+        Generator(const GeneratorConfig& config);
+
+        /* Output */
+        void writeAll(const string& dir); // 輸出 dir/config.toml 與 dir/data/*.csv (及 dir/data/gtfs)
+        void writeStops(const string& path); // 輸出 stops.csv
+        void writeSignals(const string& path); // 輸出 signals.csv
+        void writeSchedule(const string& path); // 輸出 schedule.csv
+        void writeLinkSpeeds(const string& path); // 輸出 link_speeds.csv (路段依時段的背景車流速度)
+        void writeGtfs(const string& dir); // 輸出 GTFS feed (agency, calendar, routes, trips, stops, stop_times, frequencies)
+        void writeConfig(const string& path, const string& dataDir); // 輸出 config.toml
+
+    private:
+        GeneratorConfig config;
+        mt19937 gen; // 隨機數生成器
+
+        string signalPlan(int index, bool weekend); // 產生單一號誌的全日時制字串
+};
+
+#endif
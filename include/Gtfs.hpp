@@ -0,0 +1,62 @@
+#ifndef GTFS_HPP
+#define GTFS_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 逐行讀取 CSV (GTFS 檔案)，欄位以標題名稱索引；支援以雙引號包住含逗號的欄位 */
+class CsvStream {
+    public:
+        /* Constructor */
+        CsvStream(const string& path, bool required = true); // required 為 false 時檔案不存在視為空檔
+
+        bool next(); // 讀取下一列，檔案結束時回傳 false
+        int column(const string& name) const; // 取得欄位索引，不存在時回傳 -1
+        string_view field(int index) const; // 取得目前列的欄位 (索引為 -1 或超出範圍時回傳空字串)
+        bool isOpen() const { return file.is_open(); }
+        int columns() const { return header.size(); } // 標題列的欄位數
+
+    private:
+        ifstream file;
+        string line; // 目前列 (重複使用的緩衝區)
+        string unquoted; // 含跳脫雙引號欄位的暫存區
+        vector<string> header;
+        vector<string_view> fields; // 指向 line / unquoted 的欄位
+        void split();
+};
+
+/*
+ * GTFS 班表讀取: 由 routes / trips / frequencies / stop_times / stops 篩選出單一路線的發車時間
+ *
+ * stop_times.txt 以串流方式逐列處理，只保留所選路線各班次的首站發車時間，
+ * 記憶體用量與該路線的班次數成正比，與整個 feed 的大小無關。
+ */
+class Gtfs {
+    public:
+        /* Constructor */
+        Gtfs(const string& dir); // GTFS feed 目錄
+
+        void load(const string& route, int direction = -1, const string& service = ""); // 讀取路線班表 (direction -1 或 service 空字串表示不篩選)
+
+        /* getter */
+        const vector<int>& getDepartures() const { return departures; } // 首站發車時間 (秒，已排序，可超過 24:00:00)
+        const vector<string>& getStopNames() const { return stopNames; } // 代表班次的停靠站名稱 (依停靠順序)
+        size_t getStopTimeRows() const { return stopTimeRows; } // 已讀取的 stop_times 列數
+
+        static int parseTime(string_view text); // 將 "H:MM:SS" 或 "HH:MM:SS" 轉換為秒數，格式錯誤時回傳 -1
+
+    private:
+        /* 透明雜湊，使 string_view 可直接查詢 string 鍵值 */
+        struct StringHash {
+            using is_transparent = void;
+            size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+        };
+
+        string dir;
+        vector<int> departures;
+        vector<string> stopNames;
+        size_t stopTimeRows = 0;
+};
+
+#endif
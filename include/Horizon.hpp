@@ -0,0 +1,74 @@
+#ifndef HORIZON_HPP
+#define HORIZON_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 預測模型中的站點 (快照) */
+struct HorizonStop {
+    int mileage; // 里程 (公尺)
+    double rate; // 乘客到達率 (人/秒)
+    double pax; // 候車人數 (於 lastUpdate 時)
+    double lastUpdate; // 候車人數的累積時間 (秒)
+    double lastArrive; // 上一班車的到站時間 (秒，負值表示尚無)
+};
+
+/* 預測模型中的車輛 (快照，數十 bytes，可直接複製) */
+struct HorizonBus {
+    int next; // 下一個抵達的站點
+    double eta; // 抵達 next 的時間 (秒)
+    int pax; // 車上乘客
+    double dropRate; // 下車率 (沿用最近一站的抽樣)
+    int headway; // 發車間距 (秒)
+    int hold; // 於 next 的最短置站時間 (秒)
+};
+
+/* 預測控制的選擇 */
+struct HorizonChoice {
+    double vol; // 建議行駛速度 (m/s)
+    int hold; // 下一站額外的持車時間 (秒)
+    double cost; // 預測的班距偏差 (各次到站 ((實際班距 - 發車間距) / 發車間距)^2 的總和)
+    double baseline; // 不控制 (以本次平均速度行駛、不持車) 時的預測班距偏差
+};
+
+/*
+ * 滾動時域預測控制 (策略二)
+ *
+ * 駛離站點時複製前後各 window 輛車與其間站點的輕量狀態，以簡化的事件推進 (只有到站事件、
+ * 每次取到站時間最早的車輛，線性掃描即可) 模擬接下來 stops 站內的到站、上下客與置站，
+ * 逐一試算候選的速度與持車時間，選擇預測班距偏差最小者。
+ * 模型不含號誌、停靠席位與路段速度表，其他車輛以平均速度行駛；每次試算只複製快照，成本約為 (車輛數 x 站數) 次到站。
+ */
+class Horizon {
+    public:
+        /* 參數 ([mpc] 區段) */
+        int stops = 8; // 預測的站數
+        int window = 2; // 前後各納入的車輛數
+        int speeds = 5; // 速度下限至上限間的候選速度數
+        int holds = 4; // 候選持車時間數 (0, holdStep, 2 x holdStep, ...)
+        int holdStep = 20; // 候選持車時間的間隔 (秒)
+        double Vavg; // 其他車輛及各路段的平均速度 (m/s)
+        int Tmax; // 最大置站時間 (秒)
+        int capacity; // 車輛容量
+
+        /* 快照 (由呼叫端於每次決策前填入) */
+        vector<int> mileage; // 各站里程 (依站點編號)
+        vector<HorizonStop> stop; // 站點 first .. last 的狀態
+        vector<HorizonBus> bus; // 納入的車輛 (bus[0] 為決策中的車輛，其 eta 由候選速度決定)
+        int first = 0; // 快照中第一個站點的編號
+        int last = 0; // 預測的最後一個站點
+        int from = 0; // 決策中的車輛駛離的站點
+        int now = 0; // 決策時刻 (秒)
+
+        double rollout(double vol, int hold); // 以候選速度與持車時間模擬至 last，回傳預測的班距偏差
+        HorizonChoice choose(double Vlow, double Vlimit, double Vown); // 試算所有候選並回傳最佳者
+        long long getRollouts() const { return rollouts; } // 已試算的次數
+
+    private:
+        vector<HorizonStop> stopWork; // 試算用的站點狀態 (重複使用，避免配置記憶體)
+        vector<HorizonBus> busWork; // 試算用的車輛狀態
+        long long rollouts = 0;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef LINKSPEED_HPP
+#define LINKSPEED_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * 路段背景車流速度表 (依時段)
+ *
+ * 路段以上游元素識別 (站點或號誌至路線上下一元素)，各路段每日切分為等長時段。
+ * 所有速度存放於一個連續陣列 (路段 x 時段)，查詢為 O(1)，記憶體只與路段數及時段數有關，與車輛數無關。
+ */
+class LinkSpeed {
+    public:
+        void load(const string& path, int stopAmount, int lightAmount); // 讀取速度表 CSV
+        bool empty() const { return bins == 0; }
+        int getBins() const { return bins; } // 每日時段數
+
+        /* 取得路段於 time 時的背景車流速度 (m/s，0 表示未限制) */
+        double at(int key, int time) const { return speeds[static_cast<size_t>(key) * bins + time % 86400 / binSize]; }
+
+    private:
+        vector<float> speeds; // 以 key * bins + 時段 為索引
+        int bins = 0; // 每日時段數
+        int binSize = 86400; // 時段長度 (秒)
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "TDigest.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* Streaming accumulator (Welford one-pass mean / variance) */
+struct Welford {
+    long long n = 0; // 樣本數
+    double mean = 0; // 平均值
+    double m2 = 0; // 與平均值差的平方和
+
+    void add(double x); // 加入一筆樣本
+    void merge(const Welford& other); // 合併另一個累積器 (平行重複實驗)
+    double variance() const; // 樣本變異數
+    double sd() const; // 樣本標準差
+    double cv() const; // 變異係數 (sd / mean)
+    double secondMoment() const; // 二階原點動差 E[X^2]
+};
+
+/* 績效指標引擎: 以單次掃描的累積器記錄各站、各車的績效 */
+class Metrics {
+    public:
+        /* Setup */
+        void resize(int stopAmount, int busAmount, double compression = 100); // 依站點數及車輛數配置累積器
+
+        /* Recorder (由事件處理函式呼叫) */
+        void recordDispatch(int busID, int time); // 記錄發車時間
+        void recordHeadway(int stopID, int busID, double actual, double scheduled); // 記錄實際與表定班距
+        void recordDwell(int stopID, int dwell); // 記錄上下客置站時間
+        void recordLoad(int stopID, int busID, int pax, int capacity); // 記錄離站時的載客率
+        void recordBunching(int busID, int stopID, int time, bool bunched); // 記錄連班狀態
+        void recordTrip(int busID, int stopID, int time, int distance); // 記錄抵達終點 (計算營運速度)
+        void recordBerthWait(int seconds) { berthWaiting.add(seconds); } // 記錄等候停靠席位的時間
+
+        /* Aggregation */
+        void merge(const Metrics& other); // 合併另一次模擬的績效
+        double excessWaitTime(int stopID) const; // 單站額外等候時間 (秒)
+        double excessWaitTime() const; // 全線平均額外等候時間 (秒)
+        const Welford& headway() const { return allHeadway; }
+        const Welford& load() const { return allLoad; }
+        const Welford& speed() const { return tripSpeed; }
+        const Welford& berthWait() const { return berthWaiting; }
+        long long bunchingEpisodes() const { return episodes; }
+        const TDigest& headwayQuantile() const { return headwayDigest; }
+        const TDigest& dwellQuantile() const { return dwellDigest; }
+
+        /* Report */
+        void writeJson(ostream& os) const; // 以 JSON 格式輸出所有指標
+
+        /* Checkpoint */
+        void save(CheckpointWriter& out) const;
+        void load(CheckpointReader& in);
+
+    private:
+        vector<Welford> stopHeadway; // 各站實際班距
+        vector<Welford> stopScheHeadway; // 各站表定班距
+        vector<Welford> stopLoad; // 各站離站載客率
+        vector<Welford> busHeadway; // 各車實際班距
+        vector<Welford> busLoad; // 各車載客率
+        vector<Welford> busBunching; // 各車連班持續時間 (秒)
+        vector<int> dispatchTime; // 各車發車時間
+        vector<double> busSpeed; // 各車營運速度 (kph)
+        vector<pair<int, int>> episodeStart; // 各車進行中的連班 { 起始站, 起始時間 }，-1 表示無
+        Welford allHeadway; // 全線實際班距
+        Welford allLoad; // 全線載客率
+        Welford episodeStops; // 連班持續站數
+        Welford episodeSeconds; // 連班持續時間
+        Welford tripSpeed; // 營運速度
+        Welford berthWaiting; // 等候停靠席位的時間 (秒，僅計入需要等候的到站)
+        long long episodes = 0; // 連班次數
+        vector<TDigest> stopHeadwayDigest; // 各站班距分佈
+        vector<TDigest> stopDwellDigest; // 各站置站時間分佈
+        TDigest headwayDigest; // 全線班距分佈
+        TDigest dwellDigest; // 全線置站時間分佈
+
+        static void writeWelford(ostream& os, const Welford& w);
+        static void writeQuantiles(ostream& os, const TDigest& d);
+};
+
+#endif
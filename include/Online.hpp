@@ -0,0 +1,75 @@
+#ifndef ONLINE_HPP
+#define ONLINE_HPP
+
+#include "System.hpp"
+#include "Metrics.hpp"
+#include "TDigest.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * 線上模式: 接收調度系統的到離站事件，逐班回覆控制策略的建議速度與持車時間
+ *
+ * 每則訊息為一行 JSON 物件 (回覆亦同，依收到的順序逐則回覆):
+ *   {"type":"arrive","bus":"B12","stop":3,"time":28800}  ->  {"bus":"B12","stop":3,"hold":15}
+ *   {"type":"depart","bus":"B12","stop":3,"time":28830}  ->  {"bus":"B12","stop":3,"speed":21.6,"hold":15,"bunching":true}
+ *   {"type":"stats"}                                      ->  處理延遲的分位數與訊息數
+ * time 可為秒數或 "HH:MM:SS"。hold 為建議的最短置站秒數 (上下客較久時依實際)：arrive 回覆本站，depart 回覆下一站；
+ * depart 另回覆建議速度 (kph) 及是否可能連班。
+ * 狀態只隨事件遞增更新 (各車最後的到離站、各站平均置站時間)，每則訊息的成本與營運中的車輛數成正比。
+ */
+class Online {
+    public:
+        /* Constructor */
+        Online(System& system, const toml::table& config); // 由已初始化的系統取得站點里程與控制參數，並讀取 [online] 設定
+
+        /* Service */
+        void serve(); // 接受連線並處理訊息，直到收到 SIGINT / SIGTERM (標準輸入模式則至 EOF)
+        void report() const; // 輸出摘要
+        string handle(string_view line); // 處理一則訊息並回傳回覆 (不含換行)
+
+        /* getter */
+        long long getMessages() const { return messages; } // 處理的訊息數
+        const TDigest& getLatency() const { return latency; } // 每則訊息的處理時間 (微秒)
+
+    private:
+        /* 單一車輛的即時狀態 */
+        struct Bus {
+            int stop = -1; // 最後到達或離開的站點
+            bool atStop = false; // 是否停在站點 (已到站尚未離站)
+            int time = 0; // 最後一次到離站的時間 (秒)
+            double vol = 0; // 離站後的建議速度 (m/s，用以推估目前位置)
+            int headway; // 發車間距 (秒)
+            int hold = 0; // 下一次到站時應持車的時間 (秒)
+        };
+
+        string socketPath; // Unix domain socket 路徑 ("-" 表示標準輸入 / 輸出)
+        int timeout; // 超過此時間 (秒) 沒有事件的車輛視為結束營運
+        vector<int> stops; // 各站里程 (依站點編號，即路線順序)
+        SpeedAdvisor advisor; // 控制策略
+        double Vavg; // 平均行駛速度 (m/s)
+        int Tmax; // 最大置站時間 (秒)
+        int scheduledHeadway; // 表定平均發車間距 (秒)
+
+        unordered_map<string, Bus> buses; // 營運中的車輛
+        vector<Welford> dwell; // 各站的實際置站時間 (作為下一站置站時間的預估)
+        int lastDispatch = -1; // 上一班車駛離首站的時間
+        int lastSweep = INT_MIN; // 上一次清除逾時車輛的時間
+
+        /* 統計 */
+        long long messages = 0; // 處理的訊息數
+        long long errors = 0; // 格式錯誤的訊息數
+        long long advised = 0; // 回覆建議的離站次數
+        long long bunched = 0; // 判定可能連班的離站次數
+        TDigest latency; // 每則訊息的處理時間 (微秒)
+
+        void arrive(const string& id, int stop, int time, string& reply); // 到站: 回覆本站的持車時間
+        void depart(const string& id, int stop, int time, string& reply); // 離站: 評估控制策略並回覆建議
+        double position(const Bus& bus, int now) const; // 推估車輛目前的里程
+        void serveStream(); // 標準輸入 / 輸出模式
+        void serveSocket(); // Unix domain socket 模式 (可同時服務多個連線)
+};
+
+#endif
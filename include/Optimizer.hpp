@@ -0,0 +1,54 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "Experiment.hpp"
+#include "Writer.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 最佳化的控制參數 */
+struct Parameter {
+    string key; // 欄位名稱 (System::setControl 可接受的參數，例如 time.schemeThreshold)
+    double low; // 搜尋範圍下限
+    double high; // 搜尋範圍上限
+    double initial; // 起始值 (設定檔中的值，未設定時為範圍中點)
+};
+
+/*
+ * 控制參數最佳化 (Nelder-Mead 單體法，common random numbers)
+ *
+ * 每個候選參數組以相同的 runs 個種子評估 (目標值為各次的平均)，候選之間的差異不含抽樣雜訊，
+ * 單體法的比較因此穩定。各種子只初始化一次路線與班表並模擬至分支時刻，每個候選再自該狀態 fork，
+ * 成本只有模擬本身；同一批候選 (起始單體、收縮) 與各種子在執行緒間平行評估。
+ */
+class Optimizer {
+    public:
+        /* Constructor */
+        Optimizer(const string& configPath); // 讀取設定檔 ([optimize] 區段)
+
+        /* Optimization */
+        void optimize(); // 搜尋目標值最小的參數組並輸出與起始值的比較
+
+    private:
+        toml::table config; // 設定
+        vector<Parameter> parameters; // 最佳化的參數
+        int objective = 0; // 目標值 (Outcome 的索引)
+        int runs; // 每個候選的重複實驗次數
+        int threads; // 執行緒數
+        int evaluations; // 候選評估次數上限
+        double tolerance; // 單體在單位化座標中的大小低於此值時停止
+        int forkAt = -1; // 分支時刻 (秒，-1 表示初始化後立即分支)
+        string outputPath; // 逐次評估的結果輸出 (CSV，空字串表示不輸出)
+        uint64_t baseSeed; // 第 r 次重複實驗使用種子 baseSeed + r
+
+        vector<unique_ptr<System>> bases; // 各重複實驗模擬至分支時刻的狀態 (所有候選共用)
+        int evaluated = 0; // 已評估的候選數
+        BufferedWriter output;
+
+        vector<vector<double>> evaluate(const vector<vector<double>>& points); // 平行評估一批候選 (單位化座標)，回傳各候選各次的目標值
+        vector<double> values(const vector<double>& point) const; // 單位化座標轉換為參數值
+};
+
+#endif
@@ -4,12 +4,21 @@
 #include<bits/stdc++.h>
 using namespace std;
 
+/* 綠燈時窗 (絕對時間，秒) */
+struct GreenWindow {
+    int redStart; // 紅燈開始 (前一次綠燈結束)
+    int greenStart; // 綠燈開始
+    int greenEnd; // 綠燈結束
+};
+
 class Plan {
     public:
         Plan();
         void setPhase(string config);
         int calculateSignal(int time);
         int timeRemain(int index, int target);
+        GreenWindow greenWindow(int timeStamp); // 取得 timeStamp 所在或之後的第一個綠燈時窗
+        void scale(double factor); // 各時段的週期、時差與綠燈區間等比例縮放
         
     private:
         vector<int> time;
@@ -17,6 +26,7 @@ class Plan {
         vector<int> offset;
         vector<vector<pair<int, int>>> phase;
         void processSegment(string seg);
+        pair<int, int> locate(int timeStamp); // 取得 timeStamp 所屬的時段索引及週期內的相對時間
         int time2Seconds(const string& timeStr);
 
 };
@@ -0,0 +1,95 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include<bits/stdc++.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+#endif
+
+using namespace std;
+
+/* 量測區段 (1 - 6 與事件種類代碼相同，其餘為處理函式內部的查找與排序) */
+enum class Section { None, ArriveStop, DeptStop, ArriveLight, DeptLight, AccrueDemand, EnterBerth, FindStop, FindSignal, FindNext, FindNextStop, FindPrevBus, Predict, Count };
+
+/*
+ * 事件處理剖析器: 各區段的次數與耗時、事件列表長度高水位，以及可選的 Chrome trace 記錄
+ *
+ * 每個 System 各自持有一份 (平行重複實驗時即為每個執行緒各一份)，不需任何同步，
+ * 結束後再以 merge 合併。編譯時定義 NO_PROFILE 可移除所有量測點。
+ */
+class Profiler {
+    public:
+        /* 區段統計 */
+        struct Stat {
+            long long count = 0; // 次數
+            unsigned long long ticks = 0; // 累積耗時 (計時器刻度)
+        };
+
+        /* Chrome trace 記錄 (僅記錄事件處理區段) */
+        struct TraceEvent {
+            Section section; // 區段
+            uint64_t start; // 開始刻度
+            uint64_t duration; // 持續刻度
+        };
+
+        /* Timer */
+        static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+        }
+        static double nanosPerTick(); // 計時器刻度換算為奈秒 (首次呼叫時校正)
+        static const char* name(Section section); // 區段名稱
+
+        /* Record */
+        void add(Section section, uint64_t start, uint64_t end) {
+            Stat& stat = stats[static_cast<size_t>(section)];
+            stat.count++;
+            stat.ticks += end - start;
+            if (tracing && section <= Section::EnterBerth) trace.push_back({ section, start, end - start });
+        }
+        void sampleQueue(size_t size) { queueHighWater = max(queueHighWater, size); } // 更新事件列表長度高水位
+        void setTracing(bool enabled); // 設定是否保留 Chrome trace 記錄
+        void merge(const Profiler& other); // 合併另一份剖析結果
+
+        /* getter */
+        long long count(Section section) const { return stats[static_cast<size_t>(section)].count; }
+        double nanos(Section section) const { return stats[static_cast<size_t>(section)].ticks * nanosPerTick(); }
+        size_t getQueueHighWater() const { return queueHighWater; }
+
+        /* Output */
+        void report(ostream& os) const; // 輸出剖析表
+        void writeTrace(const string& path) const; // 輸出 Chrome trace JSON (chrome://tracing 或 Perfetto)
+
+    private:
+        array<Stat, static_cast<size_t>(Section::Count)> stats{};
+        size_t queueHighWater = 0; // 事件列表長度高水位
+        bool tracing = false;
+        vector<TraceEvent> trace;
+};
+
+/* 區段計時 (建構時開始，解構時記錄) */
+class ProfileScope {
+    public:
+        ProfileScope(Profiler& profiler, Section section) : profiler(profiler), section(section), start(Profiler::now()) {}
+        ~ProfileScope() { profiler.add(section, start, Profiler::now()); }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        Profiler& profiler;
+        Section section;
+        uint64_t start;
+};
+
+#ifdef NO_PROFILE
+#define PROFILE_SCOPE(profiler, section)
+#define PROFILE_QUEUE(profiler, size)
+#else
+#define PROFILE_SCOPE(profiler, section) ProfileScope profileScope((profiler), (section))
+#define PROFILE_QUEUE(profiler, size) (profiler).sampleQueue(size)
+#endif
+
+#endif
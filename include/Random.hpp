@@ -0,0 +1,33 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * 以鍵值導出的亂數產生器 (splitmix64，符合 UniformRandomBitGenerator)
+ *
+ * 每次抽樣都由 (串流種子, 公車編號, 站點編號) 直接建立產生器，
+ * 因此同一班車在同一站的抽樣結果與事件處理順序無關。
+ * 不同控制策略改變事件先後時，各班次仍看到相同的需求與速度 (common random numbers)。
+ */
+struct KeyedRng {
+    using result_type = uint64_t;
+
+    uint64_t state;
+
+    KeyedRng(uint64_t seed, uint32_t bus, uint32_t key) : state(mix(seed ^ mix((static_cast<uint64_t>(bus) << 32) | key))) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    result_type operator()() { return mix(state += 0x9e3779b97f4a7c15ULL); }
+
+    static constexpr uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "System.hpp"
+#include "Metrics.hpp"
+#include "Writer.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * AVL 重播: 以實際的車輛定位記錄驅動公車位置，並以影子模式評估控制策略
+ *
+ * AVL 檔案 (CSV，欄位 bus, time, mileage) 以串流方式逐列讀取，只保留營運中車輛的最後位置，
+ * 記憶體與檔案大小無關。定位依里程對應至路線上的站點範圍 (站點里程 ± radius)，
+ * 以內插求得實際的到站與離站時間；每次離站時依當下其他車輛的實際位置計算控制策略的建議速度與置站時間，
+ * 並於下一站離站時與實際的路段速度與置站時間比較 (建議不影響車輛實際位置)。
+ */
+class Replay {
+    public:
+        /* Constructor */
+        Replay(System& system, const toml::table& config); // 由已初始化的系統取得站點里程與控制參數，並讀取 [replay] 設定
+
+        /* Replay */
+        void run(); // 重播整個 AVL 檔案
+        void report() const; // 輸出摘要
+
+        /* getter */
+        long long getRows() const { return rows; } // 讀取的定位筆數
+        size_t getPeakTracks() const { return peakTracks; } // 同時營運車輛數的高水位
+        double getSeconds() const { return seconds; } // 重播耗時 (秒)
+
+    private:
+        /* 透明雜湊，使 string_view 可直接查詢 string 鍵值 */
+        struct StringHash {
+            using is_transparent = void;
+            size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+        };
+
+        /* 單一車輛的重播狀態 */
+        struct Track {
+            int time = 0; // 最後一筆定位的時間 (秒)
+            double mileage = 0; // 最後一筆定位的里程 (公尺，只增不減)
+            int next = 0; // 下一個尚未離開的站點
+            int arrive = -1; // 進入目前站點範圍的時間 (-1 表示不在站點範圍內)
+            int headway; // 發車間距 (駛離首站時與前一班車的間距；自路線中途開始記錄者使用表定平均值)
+
+            /* 上一次離站時的建議 (下一站離站時與實際值比較) */
+            int adviceStop = -1; // 離開的站點 (-1 表示無)
+            int adviceTime = 0; // 離站時間
+            double adviceVol = 0; // 建議速度 (m/s)
+            int adviceDwell = 0; // 建議的下一站置站時間 (秒)
+            bool bunching = false; // 是否判定可能連班
+            double distance = -1; // 與前車的距離 (公尺，-1 表示無前車)
+        };
+
+        string path; // AVL 檔案路徑
+        string outputPath; // 逐次離站的建議與實際值輸出 (CSV，空字串表示不輸出)
+        double radius; // 站點範圍半徑 (公尺)
+        int timeout; // 超過此時間 (秒) 沒有定位的車輛視為結束營運
+        vector<int> stops; // 各站里程 (依站點編號，即路線順序)
+        SpeedAdvisor advisor; // 控制策略
+        double Vavg; // 平均行駛速度 (m/s)
+        int Tmax; // 最大置站時間 (秒)
+        int scheduledHeadway; // 表定平均發車間距 (秒)
+
+        unordered_map<string, Track, StringHash, equal_to<>> tracks; // 營運中的車輛
+        vector<Welford> dwell; // 各站的實際置站時間 (作為下一站置站時間的預估)
+        vector<int> lastArrival; // 各站上一班車的到站時間
+        int lastDispatch = -1; // 上一班車駛離首站的時間
+        BufferedWriter output;
+
+        /* 統計 */
+        long long rows = 0; // 讀取的定位筆數
+        int firstTime = INT_MAX, lastTime = INT_MIN; // 定位時間範圍 (秒)
+        double seconds = 0; // 重播耗時 (秒)
+        long long skipped = 0; // 時間倒退而略過的定位筆數
+        long long buses = 0; // 重播的車輛數
+        size_t peakTracks = 0; // 同時營運車輛數的高水位 (記憶體用量只與此有關)
+        long long departures = 0; // 評估的離站次數
+        long long bunched = 0; // 判定可能連班的離站次數
+        Welford headway; // 實際班距
+        Welford headwayDev; // 實際班距與發車間距的差 (絕對值)
+        Welford speedGap; // 建議速度與實際路段速度的差 (kph)
+        Welford dwellGap; // 建議與實際置站時間的差 (秒)
+
+        void update(string_view id, Track& track, int time, double mileage); // 依新的定位推進車輛，處理經過的站點
+        void arrive(Track& track, int stop, int time); // 進入站點範圍
+        void depart(string_view id, Track& track, int stop, int time); // 離開站點範圍 (評估控制策略)
+        int cross(const Track& track, int time, double mileage, double at) const; // 內插經過里程 at 的時間
+        void sweep(int now); // 移除超過 timeout 沒有定位的車輛
+};
+
+#endif
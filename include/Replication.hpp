@@ -0,0 +1,64 @@
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+
+#include "Experiment.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* 自適應重複實驗的一個單位 (一次模擬，或同一種子一般抽樣與對偶抽樣的平均) */
+struct Replicate {
+    static constexpr int controls = 2;
+
+    double value; // 目標值
+    array<double, controls> control; // 控制變數: 班表原始抽樣值的平均、與設定平均值之差的平方平均 (秒, 秒^2)
+    array<double, 2> runs; // 各次模擬的目標值 (對偶抽樣時為一般與對偶，否則只有第一個)
+};
+
+/* 以控制變數修正的估計值 */
+struct Estimate {
+    double mean; // 估計值
+    double halfWidth; // 95% 信賴區間半寬
+    double variance; // 單位的 (殘差) 變異數
+    int controls; // 實際使用的控制變數數 (變異數為 0 的控制變數不使用)
+};
+
+/*
+ * 自適應重複實驗 (變異數縮減)
+ *
+ * 依序模擬種子 baseSeed, baseSeed + 1, ...，每完成一個單位即更新目標值的 95% 信賴區間，
+ * 半寬低於目標 (或相對於估計值的比例低於目標，或達到次數上限) 時停止；停止與否依單位編號的順序判斷，結果與執行緒數無關。
+ * 對偶抽樣: 同一種子再以鏡射的常態抽樣 (general.antithetic) 模擬一次，兩者的平均作為一個單位。
+ * 控制變數: 班表由 schedule.avg / schedule.sd 抽樣時，以原始常態抽樣值 (取絕對值、捨去與末班車截斷之前，
+ * 每日固定 shift 個) 的平均值與離散程度為控制變數，期望值恰為 avg 與 sd^2，
+ * 以迴歸係數修正樣本平均 (發車間距偏大的重複實驗，班距偏差通常也偏大)。
+ */
+class Replication {
+    public:
+        /* Constructor */
+        Replication(const string& configPath); // 讀取設定檔 ([replication] 區段)
+
+        /* Experiment */
+        void run(); // 重複實驗至信賴區間半寬低於目標並輸出估計值
+
+    private:
+        toml::table config; // 設定 (一般抽樣)
+        toml::table mirrored; // 設定 (對偶抽樣)
+        int metric = 0; // 目標值 (Outcome 的索引)
+        double target; // 信賴區間半寬的目標
+        bool relative; // 目標是否為相對於估計值絕對值的比例
+        int minRuns; // 最少模擬次數
+        int maxRuns; // 最多模擬次數
+        int threads; // 執行緒數
+        bool antithetic; // 是否使用對偶抽樣
+        bool controlVariates; // 是否使用控制變數
+        array<double, Replicate::controls> expected{}; // 控制變數的期望值
+        string outputPath; // 逐次結果輸出 (CSV，空字串表示不輸出)
+        uint64_t baseSeed; // 第 u 個單位使用種子 baseSeed + u
+
+        Replicate simulate(int unit) const; // 模擬一個單位
+        Estimate estimate(const vector<Replicate>& units, bool useControls) const; // 樣本平均 (或以控制變數修正) 與信賴區間
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SENSITIVITY_HPP
+#define SENSITIVITY_HPP
+
+#include "Experiment.hpp"
+#include "Optimizer.hpp"
+#include "Writer.hpp"
+#include "toml.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* Sobol 低差異序列 (Joe-Kuo 方向數，最多 20 維；第 n 點可直接計算，不需依序產生) */
+class SobolSequence {
+    public:
+        static constexpr int maxDimensions = 20;
+
+        SobolSequence(int dimensions); // 計算各維的方向數
+        vector<double> point(uint32_t n) const; // 第 n 點 (各座標介於 [0, 1))
+
+    private:
+        vector<array<uint32_t, 32>> direction; // 各維的方向數
+};
+
+/* 一個參數的 Sobol 指標 (95% 信賴區間半寬由 bootstrap 估計) */
+struct SobolIndex {
+    double first; // 一階指標 S_i (單獨由此參數解釋的變異比例)
+    double firstHalfWidth;
+    double total; // 總效應指標 ST_i (含與其他參數交互作用的變異比例)
+    double totalHalfWidth;
+};
+
+/*
+ * 全域敏感度分析 (Sobol 指標，Saltelli 抽樣)
+ *
+ * 以 2d 維 Sobol 序列產生 N 組基礎樣本 A、B (各 d 個參數)，另組 d 個矩陣 AB_i (A 的第 i 欄換成 B 的第 i 欄)，
+ * 共 N x (d + 2) 次模擬。一階指標採 Saltelli (2010)，總效應指標採 Jansen 估計式。
+ * 同一列的各次模擬使用同一個種子 (common random numbers)，列間差異才來自參數；
+ * 模擬本身的隨機性不屬於任何參數，因此一階指標的總和小於 1。
+ * 參數直接覆寫設定檔的欄位 (於初始化前套用)，四個 Outcome 的指標由同一批模擬計算。
+ */
+class Sensitivity {
+    public:
+        /* Constructor */
+        Sensitivity(const string& configPath); // 讀取設定檔 ([sensitivity] 區段)
+
+        /* Analysis */
+        void analyze(); // 執行 Saltelli 抽樣的所有模擬並輸出 Sobol 指標
+
+    private:
+        toml::table config; // 設定
+        vector<Parameter> parameters; // 分析的參數 (initial 不使用)
+        vector<bool> integer; // 參數在設定檔中是否為整數
+        int samples; // 基礎樣本數 N
+        int threads; // 執行緒數
+        int bootstrap; // bootstrap 重抽次數 (信賴區間)
+        string outputPath; // 逐次模擬的結果輸出 (CSV，空字串表示不輸出)
+        uint64_t baseSeed; // 第 j 列使用種子 baseSeed + j
+
+        vector<SobolIndex> indices(const vector<Outcome>& results, int metric) const; // 計算一個目標值的各參數指標
+};
+
+#endif
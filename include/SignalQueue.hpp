@@ -0,0 +1,65 @@
+#ifndef SIGNALQUEUE_HPP
+#define SIGNALQUEUE_HPP
+
+#include "Plan.hpp"
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/*
+ * 號誌路口一般車流的停等車隊 (確定性到達與紓解)
+ *
+ * 一般車輛以固定到達率 arrival 抵達，紅燈時排隊；綠燈開始後經起動損失時間，以飽和紓解率 discharge 依序通過。
+ * 公車到達時，排在前方的車輛數由所屬週期綠燈開始時的停等車輛數解析計算，須等前方車輛紓解後才能通過；
+ * 一個綠燈無法紓解的車輛 (含公車) 順延至下一週期。
+ * 每個週期只計算一次並快取 (同一週期的後續公車直接使用)，每班車的成本固定。
+ */
+struct SignalQueue {
+    double arrival = 0; // 一般車輛到達率 (輛/秒，0 表示不使用停等車隊模型)
+    double discharge = 0; // 飽和紓解率 (輛/秒)
+    int lostTime = 0; // 綠燈起動損失時間 (秒)
+    GreenWindow cycle = { INT_MIN, INT_MIN, INT_MIN }; // 已快取的週期 (綠燈時窗)
+    double residual = 0; // 該週期紅燈開始時前一週期未紓解的車輛數
+
+    bool enabled() const { return arrival > 0; }
+
+    /* 扣除起動損失後的有效綠燈時間 (至少 1 秒) */
+    int effective(const GreenWindow& w) const { return max(1, w.greenEnd - w.greenStart - lostTime); }
+
+    /* 週期綠燈結束時仍未紓解的車輛數 (紅燈開始時的殘留車輛為 start) */
+    double overflow(const GreenWindow& w, double start) const {
+        return max(0.0, start + arrival * (w.greenEnd - w.redStart) - discharge * this->effective(w));
+    }
+
+    /*
+     * 公車於 time 抵達時可通過路口的時間 (不小於 time)
+     *
+     * windowAt(t) 回傳 t 所在或之後的第一個綠燈時窗 (號誌依日期套用不同時制，由呼叫端提供)。
+     */
+    template<typename Window>
+    int departure(int time, Window&& windowAt) {
+        GreenWindow w = windowAt(time);
+        if (w.greenStart != cycle.greenStart) { // 進入新的週期: 自快取的週期逐一推算殘留車輛，殘留為 0 後即停止
+            double carry = cycle.greenStart == INT_MIN ? 0 : this->overflow(cycle, residual);
+            for (GreenWindow next = cycle; carry > 0;) {
+                next = windowAt(next.greenEnd + 1);
+                if (next.greenStart >= w.greenStart) break;
+                carry = this->overflow(next, carry);
+            }
+            cycle = w;
+            residual = carry;
+        }
+
+        /* 排在公車前方的車輛 (自紅燈開始抵達者，含前一週期的殘留) 依序紓解 */
+        double ahead = residual + arrival * (time - w.redStart);
+        double go = w.greenEnd - this->effective(w) + ahead / discharge;
+        while (go > w.greenEnd) { // 本次綠燈無法通過: 扣除已紓解的車輛，順延至下一週期
+            ahead -= discharge * this->effective(w);
+            w = windowAt(w.greenEnd + 1);
+            go = w.greenEnd - this->effective(w) + ahead / discharge;
+        }
+        return max(time, static_cast<int>(ceil(go)));
+    }
+};
+
+#endif
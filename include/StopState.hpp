@@ -0,0 +1,64 @@
+#ifndef STOPSTATE_HPP
+#define STOPSTATE_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+ * 站點停靠席位與排隊車輛 (固定大小的環狀佇列)
+ *
+ * 佇列依到站順序存放在站點的車輛: 前 berths 輛佔用席位，其餘等候空位。
+ * 車輛依序進入席位，也依序離開 (後車完成上下客時若前車尚未離開，須等前車離開)，
+ * 因此席位與等候中的車輛可共用同一個先進先出佇列。
+ */
+struct BerthQueue {
+    static constexpr int capacity = 16; // 單站最多同時停靠與等候的車輛數
+
+    array<int, capacity> bus; // 公車編號
+    array<int, capacity> since; // 到站時間 (秒)
+    array<bool, capacity> ready; // 已完成上下客、等待前車離開
+    uint8_t head = 0; // 佇列起點
+    uint8_t size = 0; // 佇列長度
+    uint8_t berths = 0; // 停靠席位數 (0 表示不限，不使用佇列)
+
+    int at(int i) const { return (head + i) % capacity; } // 第 i 輛車在環狀陣列中的位置
+    int front() const { return bus[head]; }
+    bool full() const { return size == capacity; }
+    void push(int id, int time); // 加入佇列末端
+    void pop() { head = (head + 1) % capacity; size--; }
+    void markReady(int id); // 標記車輛已完成上下客
+    int arrivalOf(int id) const; // 車輛的到站時間 (不在佇列中時回傳 -1)
+};
+
+/*
+ * 站點候車需求 (structure of arrays): 各欄位以站點編號為索引連續存放
+ *
+ * 候車乘客以到站率線性累積，可在公車到站時只累積該站 (accrue(id, now))，
+ * 或定期一次累積所有站點 (accrue(now))；兩者都只把 [lastUpdate, now) 區間的需求加入 pax，
+ * 因此任意插入全站累積不會改變公車到站時看到的候車人數 (僅有浮點捨入誤差)。
+ */
+struct StopState {
+    vector<double> rate; // 到站率 (人/秒，於公車到站時重新抽樣，適用至下一班車到站)
+    vector<double> pax; // 候車乘客 (保留小數，避免分段累積時逐段捨去)
+    vector<double> lastUpdate; // 上次累積的時間 (秒)
+    vector<BerthQueue> berth; // 停靠席位與排隊車輛
+
+    void resize(size_t n); // 配置 n 個站點
+    size_t size() const { return pax.size(); }
+
+    /* 累積單一站點至 now (公車到站時) */
+    void accrue(int id, double now) {
+        pax[id] += rate[id] * (now - lastUpdate[id]);
+        lastUpdate[id] = now;
+    }
+    void accrue(double now); // 累積所有站點至 now (連續陣列，可向量化)
+
+    void save(CheckpointWriter& out) const; // 寫入檢查點
+    void load(CheckpointReader& in); // 自檢查點讀回
+};
+
+#endif
@@ -2,8 +2,20 @@
 #define SYSTEM_HPP
 
 #include "Event.hpp"
-#include "Bus.hpp"
+#include "FleetState.hpp"
+#include "StopState.hpp"
+#include "Gtfs.hpp"
 #include "Plan.hpp"
+#include "Metrics.hpp"
+#include "Trajectory.hpp"
+#include "Profiler.hpp"
+#include "Writer.hpp"
+#include "Random.hpp"
+#include "LinkSpeed.hpp"
+#include "SignalQueue.hpp"
+#include "Control.hpp"
+#include "Horizon.hpp"
+#include "toml.hpp"
 #include<bits/stdc++.h>
 
 using namespace std;
@@ -18,7 +30,9 @@ struct Light {
     string lightName; // 號誌化路口名稱
     int cycleTime; // 週期
     int offset; // 和前一號誌的起始時間偏差
-    Plan plan;
+    vector<Plan> plans; // 時制 (一組全週共用；兩組為平日、週末；七組為週一至週日)
+    double volume = -1; // 一般車流量 (輛/小時，signals.csv 第 4 欄，負值表示使用 signal.volume)
+    double saturation = -1; // 飽和流率 (輛/小時，signals.csv 第 5 欄，負值表示使用 signal.saturation)
 };
 
 /* Data Structure of Stop */
@@ -26,18 +40,31 @@ struct Stop {
     int id; // 編號
     bool direction; // 方向
     string stopName; // 站點名稱
-    int mileage; // 位置 (里程)
-    int pax = 0; // 站上乘客數
+    int mileage; // 位置 (里程；stops.csv 第 15 欄指定時為實際里程，否則依站距分佈抽樣)
     string note; // 站點備註
+    int berths = 0; // 停靠席位數 (stops.csv 第 14 欄，0 或省略表示不限)
     int lastArrive = -1; // 上輛車抵達的時間
     array<pair<double, double>, 3> arrivalRate;
     array<pair<double, double>, 3> dropRate;
 };
 
+/* 事件記錄輸出 (大量重複實驗時可關閉，避免格式化與輸出成本) */
+struct Console {
+    bool enabled = true;
+    template<typename T>
+    Console& operator<<(const T& value) { if (enabled) cout << value; return *this; }
+    Console& operator<<(ostream& (*manip)(ostream&)) { if (enabled) manip(cout); return *this; }
+};
+
 /* Comparators */
 struct eventCmp {
-    /* 為了使 Event 物件在 Event List (priority queue) 中能按照發生先後順序排列而設計之比較器 */
-    bool operator()(Event* a, Event* b) { return a->getTime() > b->getTime(); }
+    /* 為了使 Event 物件在 Event List (priority queue) 中能按照發生先後順序排列而設計之比較器
+       同時刻的事件再依公車編號、事件種類排序，使處理順序不受事件列表內其他事件 (例如定期累積需求) 影響 */
+    constexpr bool operator()(const Event& a, const Event& b) const {
+        if (a.getTime() != b.getTime()) return a.getTime() > b.getTime();
+        if (a.getBusID() != b.getBusID()) return a.getBusID() > b.getBusID();
+        return a.getEventType() > b.getEventType();
+    }
 };
 
 struct mileageCmp {
@@ -55,18 +82,44 @@ class System {
         System(); 
 
         /* Simulation */
-        void init(); // 初始化函數
+        void init(const string& configPath = "config.toml"); // 初始化函數
+        void init(const toml::table& config); // 以已讀入 (可能已修改) 的設定初始化
         void simulation(); // 模擬函數
         void performance(); // 計算績效函數
         void readSche(int trial); // 讀取班表函數
+        void merge(const System& other); // 合併另一次重複實驗的績效
+        void setVerbose(bool verbose); // 設定是否輸出事件記錄
+        void setTrajectory(const string& path); // 設定軌跡輸出檔案 (空字串表示不輸出)
+        void setTrace(const string& path); // 設定 Chrome trace 輸出檔案 (空字串表示不輸出)
+        void setQueueSnapshot(const string& path); // 設定候車人數快照輸出檔案 (空字串表示不輸出)
+        void saveCheckpoint(const string& path); // 將模擬狀態寫入檢查點
+        void loadCheckpoint(const string& path); // 自檢查點還原模擬狀態 (須先 init)
+        unique_ptr<System> fork() const; // 複製目前的模擬狀態 (路線、班表、車隊、事件列表及亂數串流)
+        void setPause(int time); // 設定暫停時刻: simulation 處理該時刻的事件前返回，可再 fork 或繼續
+        void setControl(const string& key, double value); // 覆寫控制參數 (time.schemeThreshold, time.Tmax, velocity.limit, velocity.low, general.scheme)
+        static bool isContinuousControl(const string& key); // 是否為可在範圍內連續取值的控制參數 (general.scheme 只能為 1 或 2)
 
         /* Func */
         optional<Stop*> getNextStop(int stopID); // 取得下一站點函數
+        static int time2Seconds(const string& timeStr); // 將 "HHMM" 轉換為秒數
 
         /* getter */
         const int getTmax(); // 取得最大置站時間
+        const Profiler& getProfile() const { return profile; } // 取得剖析結果
+        long long getEventCount() const { return eventCount; } // 取得已處理的事件數
+        int getFleetSize() const { return fleet.size(); } // 取得車隊數量
+        int getStopAmount() const { return stopAmount; } // 取得站點數量
+        vector<int> getStopMileages() const; // 取得各站里程 (依站點編號)
+        SpeedAdvisor getAdvisor() const; // 取得目前控制參數的速度建議器
+        double getAvgSpeed() const { return Vavg.value() / 3.6; } // 取得平均行駛速度 (m/s)
+        int getScheduledHeadway() const { return scheAvg.value(); } // 取得平均發車間距 (秒)
+        const vector<double>& getScheduleDraws() const { return scheduleDraws; } // 取得班表抽樣的原始常態值 (秒)
+        double getHeadwayDeviation() const { return headwayDev / replications / (fleet.size() - 1); } // 取得平均班距偏差
+        const Metrics& getMetrics() const { return metrics; } // 取得績效指標
 
     private:
+        System(const System& other) = default; // 僅供 fork 使用 (路線指標須再指向複本的站點與號誌)
+
         /* Paramemter */
         int stopAmount;
         optional<double> stopDistAvg;
@@ -74,9 +127,15 @@ class System {
         optional<double> signalDistAvg;
         optional<double> signalDistSd;
         optional<int> scheStart;
+        optional<int> scheEnd; // 每日末班車時間 (秒，跨午夜時大於 86400)
+        int days = 1; // 模擬天數
+        int startDay = 1; // 模擬第一天的星期 (1 = 週一 ... 7 = 週日)
+        array<double, 7> dayFactor; // 各星期的需求倍率
+        array<bool, 7> peakDays; // 各星期是否套用尖峰時段
         optional<int> shift;
         optional<double> scheAvg;
         optional<double> scheSd;
+        vector<double> scheduleDraws; // 班表抽樣的原始常態值 (每日固定 shift 個，未取絕對值與捨去)
         pair<int, int> morningPeak;
         pair<int, int> eveningPeak;
         optional<double> Vavg;
@@ -85,51 +144,105 @@ class System {
         optional<double> Vlow;
         optional<int> Tmax;
         optional<double> schemeThreshold;
+        int scheme = 1; // 控制策略 (1: 置站優先, 2: 滾動時域預測控制)
+        bool overtaking = true; // 是否允許公車在路段上超車
+        int minGap = 3; // 禁止超車時與前車抵達同一元素的最小時距 (秒)
         string routeName;
+        string dataDir; // 站點與號誌資料目錄
+        string scheFile; // 班表檔案 (空字串表示依 GTFS feed 或分佈產生班表)
+        string summaryPath; // 績效摘要輸出檔案路徑
+        string trajectoryPath; // 軌跡輸出檔案路徑
+        string tracePath; // Chrome trace 輸出檔案路徑
+        string queuePath; // 候車人數快照輸出檔案路徑 (空字串表示不定期累積需求)
+        int queueInterval = 60; // 候車人數快照間隔 (秒)
+        string checkpointPath; // 檢查點輸出檔案路徑
+        int checkpointAt = -1; // 儲存檢查點的時刻 (秒，-1 表示不儲存)
+        bool checkpointStop = false; // 儲存檢查點後是否結束模擬
+        bool restored = false; // 是否自檢查點接續或暫停後繼續 (發車事件已排入)
+        int pauseAt = -1; // 暫停時刻 (秒，-1 表示不暫停)
+        optional<double> compression; // 分位數 sketch 壓縮參數
         
 
         /* Variable */
         double headwayDev = 0; // 績效值: headeay deviation
+        Metrics metrics; // 績效指標 (班距變異、連班、額外等候時間、載客率、營運速度)
+        int replications = 1; // 已合併的重複實驗次數
+        Console out; // 事件記錄輸出
+        Trajectory trajectory; // 軌跡記錄 (欄位式緩衝區)
+        Profiler profile; // 事件處理剖析 (次數、耗時、事件列表高水位)
+        long long eventCount = 0; // 已處理的事件數
 
         /* Data Structures */
-        vector<Bus*> fleet; // 車隊
-        priority_queue<Event*, vector<Event*>, eventCmp> eventList; // 事件列表
+        FleetState fleet; // 車隊狀態 (班次以公車編號為索引，車輛狀態以車位為索引)
+        priority_queue<Event, vector<Event>, eventCmp> eventList; // 事件列表 (事件以值存放)
         set<variant<Stop*, Light*>, mileageCmp> route; // 路線 (號誌 + 站點)
-        map<int, function<void(Event*)>> eventSet; // 事件種類集合
+        mt19937 routeGen; // 站距與號誌間距抽樣
+        mt19937 scheduleGen; // 發車間距抽樣
+        uint64_t demandSeed; // 乘客到站率與下車率抽樣 (KeyedRng，以公車、站點為鍵)
+        uint64_t speedSeed; // 行駛速度抽樣 (KeyedRng，以公車、站點為鍵)
+        bool antithetic = false; // 對偶抽樣: 常態抽樣以平均值為中心鏡射 (與同一種子的一般抽樣負相關)
+        StopState stopState; // 各站候車需求 (以站點編號為索引)
+        vector<SignalQueue> signalQueue; // 各號誌的一般車流停等車隊 (以號誌編號為索引)
+        Horizon horizon; // 策略二的預測模型 (參數與每次決策的快照)
+        LinkSpeed linkSpeed; // 路段背景車流速度表 (以上游元素的 elementKey 為索引，未設定時為空)
+        shared_ptr<BufferedWriter> queueWriter; // 候車人數快照輸出 (僅於 simulation 期間開啟)
+        deque<Stop> stops; // 站點 (路線中存放指向此處的指標；deque 擴充時不會使指標失效)
+        deque<Light> lights; // 號誌
         vector<vector<float>> getOn; // 乘客到達率
         vector<vector<float>> getOff; // 乘客下車率
+        vector<int> lastPass; // 各路線元素上一班車抵達的時間 (站點以站點編號、號誌以站點數 + 號誌編號為索引)
         vector<int> sche; // 班表
+        vector<int> dispatchOrder; // 依發車時間排序的公車編號
+        size_t nextDispatch = 0; // 下一個待排入發車事件的班次 (dispatchOrder 索引)
 
         /* Functions */
         optional<Stop*> findNextStop(int stopID); // 取得下一站點函數
         optional<variant<Stop*, Light*>> findNext(variant<Stop*, Light*> target); // 取得路線上下一物件
         void printFormattedTime(int time); // 顯示時間函數
-        void printEventDetails(Event* e);
+        void printEventDetails(const Event& e);
         void showRoute(); // 印出路線上的元素
         void setupStop(double avg, double sd);
         void setupSignal(double avg, double sd);
         void setupSche(int start, double avg, double sd, int shift);
-        int time2Seconds(const string& timeStr); 
+        void readGtfs(const string& dir, const string& route, int direction, const string& service); // 從 GTFS feed 讀取班表
+        void addTrip(int departure, int headway); // 新增班次 (尚未發車)
+        void scheduleDispatch(); // 排入下一班次的發車事件
+        void dispatch(int bus); // 班次發車 (配置車位並排入下一班次)
         pair<int, int> timeRange2Pair(const string& timeRange);
         void displayRoute();
-        double getArrivalRate(int time, Stop* stop);
-        double getDropRate(int time, Stop* stop);
-        Bus* findPrevBus(Bus* target);
-        Bus* findBus(int id);
+        int dayOfWeek(int time); // 取得時間所屬的星期
+        int demandPeriod(int time); // 取得時間所屬的需求時段
+        Plan& signalPlan(Light* light, int time); // 取得號誌當日適用的時制
+        template<typename Generator>
+        double sample(normal_distribution<>& dist, Generator& gen) const { double x = dist(gen); return antithetic ? 2 * dist.mean() - x : x; } // 常態抽樣 (對偶抽樣時鏡射)
+        double getArrivalRate(int time, Stop* stop, KeyedRng& gen);
+        double getDropRate(int time, Stop* stop, KeyedRng& gen);
+        int findPrevBus(int target);
+        int elementKey(const Stop* stop) const { return stop->id; } // 路線元素在 lastPass 中的索引
+        int elementKey(const Light* light) const { return this->stopAmount + light->id; }
+        void predictiveControl(int slot, const Stop* stop, int now, double Vavg, Advice& advice); // 策略二: 以預測控制決定速度與持車時間
+        int arrivalTime(int slot, int from, int key, int now, int dist); // 計算自 from 抵達下一元素 key 的時間 (受路段車流速度及禁止超車時的最小時距限制)
+        bool queuedAtLight(int slot); // 禁止超車時，前車是否仍停等於同一號誌
         Stop* findStop(int id);
         Light* findSignal(int id);
-        int handlingPax(Bus* bus, Stop* stop, int time, double drop);
-        void sortedFleet();
-        void eventPerformance(Event* e, Stop* stop, Bus* bus);
+        int handlingPax(int slot, Stop* stop, int time, double drop);
+        void eventPerformance(const Event& e, Stop* stop, int bus);
         TrafficLight calculateSignal(int time, Light* light);  
         void incrHeadwayDev(float dev);
+        void writeSummary(const string& path); // 輸出績效摘要 (JSON)
+        void recordTrajectory(const Event& e); // 記錄事件發生後的公車狀態
         
 
         /* Events */
-        void arriveAtStop(Event* e); // 抵達站點事件
-        void deptFromStop(Event* e); // 離開站點事件
-        void arriveAtLight(Event* e); // 抵達號誌化路口事件
-        void deptFromLight(Event* e); // 離開號誌化路口事件
+        void arriveAtStop(const Event& e); // 抵達站點事件
+        void deptFromStop(const Event& e); // 離開站點事件
+        void arriveAtLight(const Event& e); // 抵達號誌化路口事件
+        void deptFromLight(const Event& e); // 離開號誌化路口事件
+        void accrueDemand(const Event& e); // 定期累積各站需求事件 (輸出候車人數快照)
+        void enterBerth(const Event& e); // 排隊中的公車進入停靠席位事件
+        void serveAtStop(const Event& e, Stop* stop, int bus, int slot); // 進入席位後處理上下客並排入離站事件
+        bool leaveBerth(const Event& e); // 依序離開停靠席位 (被前方車輛阻擋時回傳 false)
+        void seedStreams(optional<int64_t> seed); // 設定各亂數串流的種子 (未指定時以 random_device 產生)
 
         
 };
@@ -0,0 +1,47 @@
+#ifndef TDIGEST_HPP
+#define TDIGEST_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/* Mergeable quantile sketch (merging t-digest) */
+class TDigest {
+    public:
+        /* Constructor */
+        TDigest(double compression = 100); // 給定壓縮參數 (越大越精準，記憶體越多)
+
+        /* Update */
+        void add(double x, double weight = 1); // 加入一筆樣本
+        void merge(const TDigest& other); // 合併另一個 sketch (平行重複實驗)
+
+        /* Query */
+        double quantile(double q) const; // 取得第 q 分位數 (0 <= q <= 1)
+        double count() const; // 取得樣本總權重
+        size_t size() const; // 取得質心數量 (記憶體用量)
+
+        /* Checkpoint */
+        void save(CheckpointWriter& out) const;
+        void load(CheckpointReader& in);
+
+    private:
+        struct Centroid {
+            double mean; // 質心平均值
+            double weight; // 質心權重
+        };
+
+        double compression; // 壓縮參數
+        mutable vector<Centroid> centroids; // 已壓縮的質心 (依平均值排序)
+        mutable vector<Centroid> buffer; // 尚未壓縮的樣本
+        mutable double total = 0; // 已壓縮的總權重
+        double minValue = numeric_limits<double>::infinity(); // 最小值
+        double maxValue = -numeric_limits<double>::infinity(); // 最大值
+
+        void compress() const; // 將緩衝區合併進質心
+        double scale(double q) const; // k1 尺度函數
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* Columnar trajectory recorder (每車一組欄位緩衝區，模擬結束時一次寫出) */
+class Trajectory {
+    public:
+        /* Setup */
+        void reserve(int busAmount, size_t pointsPerBus); // 預先配置每車的緩衝區
+        void clear(); // 清除所有記錄
+
+        /* Recorder */
+        void record(int busID, int time, int mileage, double velocity, int pax, int eventType); // 記錄一筆軌跡點
+
+        /* Query */
+        size_t size() const; // 軌跡點總數
+        size_t bytes() const; // 軌跡點佔用的記憶體 (bytes)
+
+        /* Output */
+        void write(const string& path) const; // 依副檔名輸出 (.bin 為二進位，其餘為 CSV)
+        void writeCsv(const string& path) const; // 輸出 CSV (bus,time,mileage,velocity,event,load)
+        void writeBinary(const string& path) const; // 輸出二進位欄位格式
+
+    private:
+        /* 單一車輛的欄位緩衝區: 時間與里程以相對前一點的差值儲存，每點 9 bytes */
+        struct Columns {
+            int baseTime = -1; // 第一點的時間 (秒)
+            int baseMileage = 0; // 第一點的里程 (公尺)
+            int lastTime = 0; // 最後一點的時間，用於計算差值
+            int lastMileage = 0; // 最後一點的里程，用於計算差值
+            vector<uint16_t> dTime; // 時間差 (秒)
+            vector<uint16_t> dMileage; // 里程差 (公尺)
+            vector<uint16_t> velocity; // 速度 (cm/s)
+            vector<uint16_t> pax; // 車上乘客數
+            vector<uint8_t> event; // 事件種類代碼
+        };
+
+        vector<Columns> buses; // 以公車編號索引的欄位緩衝區
+        size_t reserved = 0; // 每車預先配置的點數
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef WRITER_HPP
+#define WRITER_HPP
+
+#include<bits/stdc++.h>
+
+using namespace std;
+
+/* Buffered text writer (大量輸出時避免 iostream 的格式化與同步成本) */
+class BufferedWriter {
+    public:
+        /* Constructor */
+        BufferedWriter(size_t capacity = 1 << 16); // 給定緩衝區大小 (bytes)
+        ~BufferedWriter();
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        /* File */
+        void open(const string& path); // 開啟輸出檔案 (覆寫)
+        void close(); // 寫出緩衝區並關閉檔案
+        bool isOpen() const { return file != nullptr; }
+
+        /* Output */
+        BufferedWriter& operator<<(char c);
+        BufferedWriter& operator<<(const char* s);
+        BufferedWriter& operator<<(const string& s);
+        BufferedWriter& operator<<(int v);
+        BufferedWriter& operator<<(long long v);
+        BufferedWriter& operator<<(double v);
+        void write(const void* data, size_t size); // 寫出原始位元組 (二進位格式)
+        void flush(); // 將緩衝區寫入檔案
+
+    private:
+        FILE* file = nullptr; // 輸出檔案
+        vector<char> buffer; // 緩衝區
+        size_t used = 0; // 緩衝區已使用的長度
+
+        char* reserve(size_t size); // 確保緩衝區尚有 size bytes 可用
+};
+
+#endif
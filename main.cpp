@@ -1,13 +1,99 @@
 #include <bits/stdc++.h>
 #include "System.hpp"
+#include "Experiment.hpp"
+#include "Optimizer.hpp"
+#include "Replication.hpp"
+#include "Sensitivity.hpp"
+#include "Replay.hpp"
+#include "Online.hpp"
 #include "toml.hpp"
 
 using namespace std;
 
-int main() {
+int main(int argc, char** argv) {
     srand(time(0));
-    System system;
-    system.init();
-    system.simulation();
-    system.performance();
-}
\ No newline at end of file
+    string configPath = argc > 1 ? argv[1] : "config.toml"; // 用法: ./bus1 [config.toml]
+
+    /* 讀取重複實驗設定 */
+    auto config = toml::parse_file(configPath);
+    int runs = max(1, config["replication"]["runs"].value_or(1));
+    int threads = clamp(config["replication"]["threads"].value_or(1), 1, runs);
+
+    if (config["compare"]["runs"].value_or(0) > 0) { // 配對比較不同控制策略 (common random numbers)
+        Experiment(configPath).compare();
+        return 0;
+    }
+
+    if (config["optimize"]["evaluations"].value_or(0) > 0) { // 以 Nelder-Mead 搜尋控制參數 (common random numbers)
+        Optimizer(configPath).optimize();
+        return 0;
+    }
+
+    if (config["sensitivity"]["samples"].value_or(0) > 0) { // 全域敏感度分析 (Saltelli 抽樣、Sobol 指標)
+        Sensitivity(configPath).analyze();
+        return 0;
+    }
+
+    if (config["replication"]["halfWidth"].value_or(0.0) > 0) { // 自適應重複實驗: 信賴區間半寬低於目標即停止 (可搭配對偶抽樣與控制變數)
+        Replication(configPath).run();
+        return 0;
+    }
+
+    if (!string(config["replay"]["file"].value_or("")).empty()) { // 以 AVL 記錄重播並評估控制策略 (影子模式)
+        System system;
+        system.init(configPath);
+        Replay replay(system, config);
+        replay.run();
+        replay.report();
+        return 0;
+    }
+
+    if (string socket = config["online"]["socket"].value_or(""); !socket.empty()) { // 線上模式: 接收到離站事件並回覆建議
+        if (socket == "-") cout.rdbuf(cerr.rdbuf()); // 標準輸出只保留回覆，其餘訊息改寫至標準錯誤
+        System system;
+        system.init(configPath);
+        Online online(system, config);
+        online.serve();
+        online.report();
+        return 0;
+    }
+
+    if (runs == 1) {
+        System system;
+        system.init(configPath);
+        system.simulation();
+        system.performance();
+        return 0;
+    }
+
+    /* 平行重複實驗: 每個執行緒各自建立系統並在本地合併績效，最後再合併各執行緒的結果 */
+    auto seed = config["general"]["seed"].value<int64_t>(); // 指定種子時第 r 次重複實驗使用 seed + r (同 Experiment)，否則各次自行產生種子
+    vector<unique_ptr<System>> partial(threads);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int r = t; r < runs; r += threads) {
+                toml::table table = config;
+                if (seed) table["general"].as_table()->insert_or_assign("seed", *seed + r);
+                auto system = make_unique<System>();
+                system->init(table);
+                if (threads > 1) system->setVerbose(false); // 多執行緒時關閉事件記錄，避免輸出交錯
+                system->setTrajectory(""); // 重複實驗只輸出合併後的摘要
+                system->setTrace("");
+                system->setQueueSnapshot("");
+                system->simulation();
+                if (!partial[t]) {
+                    partial[t] = move(system);
+                } else {
+                    partial[t]->merge(*system);
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    for (int t = 1; t < threads; t++) {
+        partial[0]->merge(*partial[t]);
+    }
+    partial[0]->performance();
+}
@@ -1,25 +1,26 @@
-import re
+import json
+import sys
 
-def calculate_avg_headway(file_path):
+def calculate_avg_headway(file_paths):
     total_deviation = 0
     count = 0
-    
-    with open(file_path, 'r') as file:
-        for line in file:
-            match = re.search(r"Avg headway deviation:\s*([\d.]+)", line)
-            if match:
-                total_deviation += float(match.group(1))
-                count += 1
-    
+
+    for file_path in file_paths:
+        with open(file_path, 'r') as file:
+            summary = json.load(file)
+        runs = summary.get("replications", 1)
+        total_deviation += summary["headwayDeviation"]["avg"] * runs
+        count += runs
+
     if count == 0:
-        print("No 'Avg headway deviation' values found.")
+        print("No summary files found.")
         return None
-    
+
     average = total_deviation / count
     return average
 
-file_path = file_path = "result.txt"
-average_deviation = calculate_avg_headway(file_path)
+file_paths = sys.argv[1:] or ["summary.json"]
+average_deviation = calculate_avg_headway(file_paths)
 
 if average_deviation is not None:
     print(f"The overall average of 'Avg headway deviation' is: {average_deviation:.4f}")
@@ -1,14 +1,31 @@
 #!/bin/bash
+# 用法: scripts/run.sh [相對半寬目標 (95% 信賴區間半寬 / |估計值|，預設 0.1)] [設定檔 (預設 config.toml)]
+# 自適應重複實驗: 模擬至平均班距偏差的信賴區間半寬低於估計值的目標比例 (或達到 replication.maxRuns) 為止；
+# 班表由 schedule.avg / schedule.sd 抽樣 (未指定 schedule.file 或 schedule.gtfs) 時才使用控制變數。
+# 設定檔沒有 [replication] 區段時 (例如 gen1 產生的情境) 自動加入；逐次結果寫入 results/replications.csv
 
-executable="./bus"
-output_file="result.txt"
+executable="./bus1"
+target="${1:-0.1}"
+config="${2:-config.toml}"
+output_dir="results"
 
-> "$output_file"
+mkdir -p "$output_dir"
+run_config="$output_dir/replication.toml"
 
-for i in $(seq 1 100); do
-    echo "Run #$i" >> "$output_file"
-    "$executable" >> "$output_file"
-    echo "" >> "$output_file"
-done
+# 班表是否由常態分佈抽樣 ([schedule] 區段沒有非空的 file 或 gtfs)
+sampled=$(awk '/^\[/ { inside = ($0 == "[schedule]") }
+    inside && /^(file|gtfs)[ \t]*=[ \t]*"[^"]+"/ { fixed = 1 }
+    END { print fixed ? "false" : "true" }' "$config")
 
-echo "saved all 100 result to $output_file"
\ No newline at end of file
+settings="halfWidth = $target\nrelative = true\ncontrolVariates = $sampled\noutput = \"$output_dir/replications.csv\""
+awk -v settings="$settings" '/^\[/ {
+        inside = ($0 == "[replication]")
+        print
+        if (inside) { print settings; found = 1 }
+        next
+    }
+    inside && /^(halfWidth|relative|controlVariates|output)[ \t]*=/ { next }
+    { print }
+    END { if (!found) printf "\n[replication]\n%s\n", settings }' "$config" > "$run_config"
+
+"$executable" "$run_config" | grep -v "^Start simulation"
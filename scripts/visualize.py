@@ -1,45 +1,60 @@
-import re
+import csv
+import json
+import struct
+import sys
 import matplotlib.pyplot as plt
-from datetime import datetime
 
-file_path = "result.txt"
-with open(file_path, "r") as file:
-    raw_data = file.read()
+file_path = sys.argv[1] if len(sys.argv) > 1 else "trajectory.csv"
+summary_path = sys.argv[2] if len(sys.argv) > 2 else "summary.json"
 
-bus_event_pattern = re.compile(
-    r"Time:\s(?P<time>[\d:]+)\n(?:New Event:\s)?Bus\s(?P<bus_id>\d+)\s(?P<event>arrive at|depart from|arrive at light|depart from light)\s(?:stop|light)?\s?(?P<stop_id>\d+)?\n(?:mileage\s=\s(?P<mileage>\d+))?"
-)
+def read_csv(path):
+    bus_data = {}
+    with open(path, "r") as file:
+        for row in csv.DictReader(file):
+            bus_id = int(row["bus"])
+            if bus_id not in bus_data:
+                bus_data[bus_id] = {"time": [], "mileage": []}
 
-bus_data = {}
+            bus_data[bus_id]["time"].append(int(row["time"]))
+            bus_data[bus_id]["mileage"].append(int(row["mileage"]))
+    return bus_data
 
-for match in bus_event_pattern.finditer(raw_data):
-    print(f"Matched: {match.groupdict()}") 
-    
-    time_str = match.group("time")
-    bus_id = int(match.group("bus_id"))
-    event = match.group("event")
-    stop_id = match.group("stop_id")
-    mileage = match.group("mileage")
+def read_binary(path):
+    # Layout written by Trajectory::writeBinary
+    bus_data = {}
+    with open(path, "rb") as file:
+        raw = file.read()
+    if raw[:4] != b"BTRJ":
+        raise ValueError(f"{path} is not a trajectory file")
+    _, bus_count = struct.unpack_from("<II", raw, 4)
+    offset = 12
+    for _ in range(bus_count):
+        bus_id, count, time, mileage = struct.unpack_from("<IIII", raw, offset)
+        offset += 16
+        d_time = struct.unpack_from(f"<{count}H", raw, offset)
+        d_mileage = struct.unpack_from(f"<{count}H", raw, offset + 2 * count)
+        offset += 8 * count + count  # dTime, dMileage, velocity, pax (uint16) + event (uint8)
 
-    time_obj = datetime.strptime(time_str, "%H:%M:%S")
-    time_in_seconds = time_obj.hour * 3600 + time_obj.minute * 60 + time_obj.second
+        times, mileages = [], []
+        for dt, dm in zip(d_time, d_mileage):
+            time += dt
+            mileage += dm
+            times.append(time)
+            mileages.append(mileage)
+        if count:
+            bus_data[bus_id] = {"time": times, "mileage": mileages}
+    return bus_data
 
-    if bus_id not in bus_data:
-        bus_data[bus_id] = {"time": [], "mileage": []}
+bus_data = read_binary(file_path) if file_path.endswith(".bin") else read_csv(file_path)
 
-    bus_data[bus_id]["time"].append(time_in_seconds)
-    bus_data[bus_id]["mileage"].append(int(mileage) if mileage else None)
-
-print(f"Bus Data: {bus_data}")
+with open(summary_path, "r") as file:
+    summary = json.load(file)
 
 plt.figure(figsize=(10, 6))
-for bus_id, data in bus_data.items():
-    valid_data = [(t, m) for t, m in zip(data["time"], data["mileage"]) if m is not None]
-    if valid_data:
-        times, mileages = zip(*valid_data)
-        plt.plot(times, mileages, marker="o", markersize=0, label=f"Bus {bus_id}")
+for bus_id, data in sorted(bus_data.items()):
+    plt.plot(data["time"], data["mileage"], marker="o", markersize=0, label=f"Bus {bus_id}")
 
-plt.title("Scheme 1 Time-Space Diagram (Overall Average Headway Deviation = 11.83)")
+plt.title(f"Time-Space Diagram (Average Headway Deviation = {summary['headwayDeviation']['avg']:.2f})")
 plt.xlabel("Time (seconds)")
 plt.ylabel("Mileage (meters)")
 plt.legend()
@@ -47,4 +62,4 @@ plt.grid(True)
 
 output_path = "bus_time_mileage_chart.png"
 plt.savefig(output_path)
-print(f"saved plot to {output_path}")
\ No newline at end of file
+print(f"saved plot to {output_path}")